@@ -0,0 +1,123 @@
+#include "BenchmarkRunner.h"
+#include <boost/chrono.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <streambuf>
+
+/*
+	Stream buffer which discards everything written to it. Used to silence the debugging output of the objects being measured
+*/
+class NullBuffer : public std::streambuf {
+protected:
+	int overflow(int c) override {
+		return c;
+	}
+};
+
+BenchmarkRunner::BenchmarkRunner(double minTime, long maxIterations) : m_minTime(minTime), m_maxIterations(maxIterations) {
+}
+
+void BenchmarkRunner::add(const std::string &name, std::function<void()> function, double itemsPerIteration, const std::string &itemName) {
+	m_benchmarks.push_back({ name, function, itemsPerIteration, itemName });
+}
+
+void BenchmarkRunner::setFilter(const std::string &filter) {
+	m_filter = filter;
+}
+
+void BenchmarkRunner::setMinTime(double minTime) {
+	m_minTime = minTime;
+}
+
+/*
+	Runs all the benchmarks which match the filter. Each benchmark is run once before timing starts to warm up caches and connections
+*/
+void BenchmarkRunner::run() {
+	typedef boost::chrono::steady_clock Clock;
+
+	std::cout << boost::format("%-36s %10s %14s %14s %14s %16s") % "Benchmark" % "Iterations" % "Mean (us)" % "Median (us)" % "Min (us)" % "Throughput" << std::endl;
+
+	for (Benchmark &benchmark : m_benchmarks) {
+		if (!m_filter.empty() && benchmark.name.find(m_filter) == std::string::npos) {
+			continue;
+		}
+
+		NullBuffer nullBuffer;
+		std::streambuf *coutBuffer = std::cout.rdbuf(&nullBuffer);
+
+		std::vector<double> times;
+
+		try {
+			benchmark.function();
+
+			Clock::time_point start = Clock::now();
+
+			while (static_cast<long>(times.size()) < m_maxIterations && (times.empty() || boost::chrono::duration<double>(Clock::now() - start).count() < m_minTime)) {
+				Clock::time_point iterationStart = Clock::now();
+				benchmark.function();
+				times.push_back(boost::chrono::duration<double, boost::nano>(Clock::now() - iterationStart).count());
+			}
+		}
+		catch (std::exception &e) {
+			std::cout.rdbuf(coutBuffer);
+			std::cerr << benchmark.name << " failed: " << e.what() << std::endl;
+			continue;
+		}
+
+		std::cout.rdbuf(coutBuffer);
+
+		std::vector<double> sorted = times;
+		std::sort(sorted.begin(), sorted.end());
+
+		BenchmarkResult result;
+		result.name = benchmark.name;
+		result.iterations = static_cast<long>(times.size());
+		result.meanNs = 0;
+
+		for (double time : times) {
+			result.meanNs += time / times.size();
+		}
+
+		result.medianNs = sorted[sorted.size() / 2];
+		result.minNs = sorted.front();
+		result.maxNs = sorted.back();
+		result.itemsPerSecond = benchmark.itemsPerIteration * 1e9 / result.meanNs;
+		result.itemName = benchmark.itemName;
+
+		m_results.push_back(result);
+
+		std::cout << boost::format("%-36s %10d %14.2f %14.2f %14.2f %12.4g %s/s") % result.name % result.iterations % (result.meanNs / 1e3) % (result.medianNs / 1e3) % (result.minNs / 1e3) % result.itemsPerSecond % result.itemName << std::endl;
+	}
+}
+
+/*
+	Writes the results to a JSON file
+*/
+bool BenchmarkRunner::writeJSON(const std::string &path) {
+	std::ofstream file(path);
+
+	if (!file) {
+		std::cerr << "Unable to open " << path << " for writing" << std::endl;
+		return false;
+	}
+
+	file << "{\n  \"benchmarks\": [\n";
+
+	for (std::size_t i = 0; i < m_results.size(); i++) {
+		const BenchmarkResult &result = m_results[i];
+
+		file << boost::format("    {\"name\": \"%s\", \"iterations\": %d, \"mean_ns\": %.1f, \"median_ns\": %.1f, \"min_ns\": %.1f, \"max_ns\": %.1f, \"items_per_second\": %.6g, \"item\": \"%s\"}")
+			% result.name % result.iterations % result.meanNs % result.medianNs % result.minNs % result.maxNs % result.itemsPerSecond % result.itemName;
+		file << ((i + 1 < m_results.size()) ? ",\n" : "\n");
+	}
+
+	file << "  ]\n}\n";
+
+	return static_cast<bool>(file);
+}
+
+const std::vector<BenchmarkResult> &BenchmarkRunner::getResults() {
+	return m_results;
+}
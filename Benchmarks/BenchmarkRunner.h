@@ -0,0 +1,49 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+	Minimal benchmark runner. Every benchmark is a function which performs one iteration of the work being measured. The function is run repeatedly
+	until the minimum run time has passed, and the timing of every iteration is recorded.
+	The results are printed as a table and written to a JSON file so that they can be compared between builds.
+*/
+struct BenchmarkResult {
+	std::string name;
+	long iterations;
+	double meanNs;
+	double medianNs;
+	double minNs;
+	double maxNs;
+	double itemsPerSecond; // Throughput in items per second, where the meaning of an item is given by itemName
+	std::string itemName;
+};
+
+class BenchmarkRunner {
+private:
+	struct Benchmark {
+		std::string name;
+		std::function<void()> function;
+		double itemsPerIteration;
+		std::string itemName;
+	};
+
+	std::vector<Benchmark> m_benchmarks;
+	std::vector<BenchmarkResult> m_results;
+
+	double m_minTime; // Minimum time, in seconds, for which each benchmark is run
+	long m_maxIterations;
+	std::string m_filter; // Only benchmarks with a name containing the filter are run
+
+public:
+	BenchmarkRunner(double minTime = 0.5, long maxIterations = 100000);
+
+	void add(const std::string &name, std::function<void()> function, double itemsPerIteration = 1, const std::string &itemName = "iterations");
+	void setFilter(const std::string &filter);
+	void setMinTime(double minTime);
+
+	void run();
+	bool writeJSON(const std::string &path);
+
+	const std::vector<BenchmarkResult> &getResults();
+};
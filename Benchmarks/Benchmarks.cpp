@@ -0,0 +1,392 @@
+#include "BenchmarkRunner.h"
+#include "CaptureReplayer.h"
+#include "SimulatedAnalyser.h"
+#include "SimulatedHiSLIPServer.h"
+#include "AnalyserObj.h"
+#include "FastFormat.h"
+#include "GainCalibration.h"
+#include "MeasurementArchive.h"
+#include "MeasurementCube.h"
+#include "MeasurementExporter.h"
+#include "MeasurementSystem.h"
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#ifndef _WIN32
+#include "SimulatedRotator.h"
+#include "SimulatedSwitchMatrix.h"
+#endif
+
+/*
+	Benchmark suite covering the acquisition path, from formatting the SCPI commands to writing the measured data to disk.
+	The instruments are replaced by SimulatedAnalyser and SimulatedRotator so that the suite runs on any computer.
+	Usage: Benchmarks [--output results.json] [--filter name] [--min-time seconds] [--capture session.cmc]
+	The replay benchmark replays a capture of a measureCut(0, 90) session. By default such a session is recorded against the simulated instruments,
+	--capture replays a session recorded in the chamber instead.
+*/
+
+static const int SAMPLEPOINTS = 1601;
+
+/*
+	Creates the traces of a synthetic azimuth cut
+*/
+static std::vector<MeasurementTrace> makeCut(int angles, double stepAngle, AnalyserFormat format) {
+	std::vector<MeasurementTrace> traces(angles);
+
+	for (int a = 0; a < angles; a++) {
+		MeasurementTrace &trace = traces[a];
+		trace.angle = a * stepAngle;
+		trace.startFreq = 400e6;
+		trace.stopFreq = 3e9;
+		trace.parameter = S21;
+		trace.format = format;
+		trace.data.resize(2 * SAMPLEPOINTS);
+
+		for (int i = 0; i < SAMPLEPOINTS; i++) {
+			trace.data[2 * i] = -20.0 + 10.0 * std::cos(0.01 * i + 0.1 * a);
+			trace.data[2 * i + 1] = (format == SMIT) ? 5.0 * std::sin(0.01 * i - 0.1 * a) : 0.0;
+		}
+	}
+
+	return traces;
+}
+
+/*
+	Creates a binary data block like the one sent by the analyser
+*/
+static std::vector<char> makeBlock(AnalyserDataTransferFormat dtf) {
+	std::size_t sampleSize = AnalyserDataTransferFormatSize.at(dtf);
+	std::vector<char> block(2 * SAMPLEPOINTS * sampleSize);
+
+	for (int i = 0; i < 2 * SAMPLEPOINTS; i++) {
+		double value = -20.0 + 10.0 * std::sin(0.01 * i);
+
+		if (dtf == REAL32) {
+			float sample = static_cast<float>(value);
+			std::memcpy(&block[i * sampleSize], &sample, sizeof(sample));
+		}
+		else {
+			std::memcpy(&block[i * sampleSize], &value, sizeof(value));
+		}
+	}
+
+	return block;
+}
+
+int main(int argc, char *argv[]) {
+	std::string outputPath = "bench_output.json";
+	std::string capturePath;
+	BenchmarkRunner runner;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string option = argv[i];
+
+		if (option == "--output") {
+			outputPath = argv[i + 1];
+		}
+		else if (option == "--filter") {
+			runner.setFilter(argv[i + 1]);
+		}
+		else if (option == "--min-time") {
+			runner.setMinTime(std::atof(argv[i + 1]));
+		}
+		else if (option == "--capture") {
+			capturePath = argv[i + 1];
+		}
+	}
+
+	boost::filesystem::path workDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("cmt-bench-%%%%%%");
+	boost::filesystem::create_directories(workDir);
+
+	/*
+		SCPI command formatting, in the same way as the setters of AnalyserObj
+	*/
+	runner.add("scpi_format_frequency_range", []() {
+		std::string command = boost::str(boost::format{ ":SENS%d:FREQ:STAR %f;:SENS%d:FREQ:STOP %f" } % 1 % 400e6 % 1 % 3e9);
+		if (command.empty()) std::abort();
+	}, 1, "commands");
+
+	runner.add("scpi_format_data_query", []() {
+		std::string command = boost::str(boost::format{ ":CALC%d:TRAC%d:DATA:FDAT?" } % 1 % 1);
+		if (command.empty()) std::abort();
+	}, 1, "commands");
+
+	/*
+		Block decoding of the binary data sent by the analyser
+	*/
+	std::vector<char> realBlock = makeBlock(REAL);
+	std::vector<char> real32Block = makeBlock(REAL32);
+	std::vector<double> decoded(2 * SAMPLEPOINTS);
+
+	runner.add("decode_block_real", [&]() {
+		AnalyserObj<double>::decodeSamples(realBlock.data(), decoded.size(), REAL, decoded.data());
+	}, 2 * SAMPLEPOINTS, "samples");
+
+	runner.add("decode_block_real32", [&]() {
+		AnalyserObj<double>::decodeSamples(real32Block.data(), decoded.size(), REAL32, decoded.data());
+	}, 2 * SAMPLEPOINTS, "samples");
+
+	runner.add("decode_block_real32_split", [&]() {
+		AnalyserObj<double>::decodeComplexSamples(real32Block.data(), SAMPLEPOINTS, REAL32, decoded.data(), decoded.data() + SAMPLEPOINTS);
+	}, 2 * SAMPLEPOINTS, "samples");
+
+	/*
+		Number to text conversion used by the exporters, compared with the standard library
+	*/
+	std::vector<double> values = makeCut(1, 1, SMIT).front().data;
+	std::vector<char> text(values.size() * FASTFORMAT_MAXLENGTH);
+
+	runner.add("convert_fastformat_scientific", [&]() {
+		char *out = text.data();
+		for (double value : values) {
+			out = formatScientific(out, value, 6);
+			*out++ = ' ';
+		}
+	}, 2 * SAMPLEPOINTS, "values");
+
+	runner.add("convert_snprintf_scientific", [&]() {
+		char *out = text.data();
+		for (double value : values) {
+			out += std::snprintf(out, FASTFORMAT_MAXLENGTH, "%.6e ", value);
+		}
+	}, 2 * SAMPLEPOINTS, "values");
+
+	runner.add("convert_ostream_scientific", [&]() {
+		std::ostringstream stream;
+		stream.precision(6);
+		stream << std::scientific;
+		for (double value : values) {
+			stream << value << ' ';
+		}
+	}, 2 * SAMPLEPOINTS, "values");
+
+	/*
+		File writes of a full cut of 72 angles
+	*/
+	std::vector<MeasurementTrace> cut = makeCut(72, 5.0, SMIT);
+	MeasurementExporter exporter;
+
+	runner.add("write_touchstone_cut", [&]() {
+		if (!exporter.exportTouchstone(cut, workDir.string(), "bench")) throw std::runtime_error("Touchstone export failed");
+	}, static_cast<double>(cut.size()), "traces");
+
+	runner.add("write_csv_cut", [&]() {
+		if (!exporter.exportCSV(cut, workDir.string(), "bench")) throw std::runtime_error("CSV export failed");
+	}, static_cast<double>(cut.size()), "traces");
+
+	runner.add("write_archive_cut", [&]() {
+		boost::filesystem::remove_all(workDir / "archive");
+		MeasurementArchive archive((workDir / "archive").string());
+		if (!archive.addCampaign("bench", "0001", 0, cut)) throw std::runtime_error("Archive write failed");
+	}, static_cast<double>(cut.size()), "traces");
+
+	/*
+		Compressed archives. The synthetic cut is made noisy and rounded to floats, as if it was transferred as REAL32, so that it compresses like
+		measured data rather than like a pure sine. The reads include summing every value, since the uncompressed data is only read from the
+		mapped file when it is used. The files are in the page cache, so the disk itself is not measured
+	*/
+	std::vector<MeasurementTrace> noisyCut = cut;
+	unsigned int seed = 1;
+
+	for (MeasurementTrace &trace : noisyCut) {
+		for (double &value : trace.data) {
+			seed = seed * 1664525u + 1013904223u;
+			value = static_cast<float>(value + 1e-3 * (static_cast<double>(seed >> 8) / (1 << 24) - 0.5));
+		}
+	}
+
+	runner.add("write_archive_cut_compressed", [&]() {
+		boost::filesystem::remove_all(workDir / "archive_compressed");
+		MeasurementArchive archive((workDir / "archive_compressed").string());
+		archive.setCompression(true);
+		if (!archive.addCampaign("bench", "0001", 0, noisyCut)) throw std::runtime_error("Archive write failed");
+	}, static_cast<double>(noisyCut.size()), "traces");
+
+	auto readArchive = [&](const std::string &name, bool compression) {
+		boost::filesystem::path directory = workDir / name;
+
+		if (!boost::filesystem::exists(directory)) {
+			MeasurementArchive archive(directory.string());
+			archive.setCompression(compression);
+			if (!archive.addCampaign("bench", "0001", 0, noisyCut)) throw std::runtime_error("Archive write failed");
+		}
+
+		MeasurementArchive archive(directory.string());
+		double sum = 0;
+
+		for (const ArchiveSlice &slice : archive.query(ArchiveQuery())) {
+			for (int trace = 0; trace < slice.getTraceCount(); trace++) {
+				const double *data = slice.getTrace(trace);
+				for (int i = 0; i < 2 * slice.getPointCount(); i++) {
+					sum += data[i];
+				}
+			}
+		}
+
+		if (!std::isfinite(sum)) throw std::runtime_error("Archive read failed");
+	};
+
+	runner.add("read_archive_cut", [&]() {
+		readArchive("archive_read", false);
+	}, static_cast<double>(noisyCut.size()), "traces");
+
+	runner.add("read_archive_cut_compressed", [&]() {
+		readArchive("archive_read_compressed", true);
+	}, static_cast<double>(noisyCut.size()), "traces");
+
+	/*
+		Capture of traces from the simulated analyser over the local network
+	*/
+	SimulatedAnalyser simulatedAnalyser;
+	boost::scoped_ptr<AnalyserObj<double>> analyser;
+
+	runner.add("capture_trace_real32", [&]() {
+		if (!analyser) {
+			analyser.reset(new AnalyserObj<double>(400e6, 3e9, 0, 5e3, SAMPLEPOINTS, SMIT, S21, REAL32, "127.0.0.1", simulatedAnalyser.getPort()));
+		}
+		analyser->setDataTransferFormat(REAL32);
+		if (analyser->captureData().empty()) throw std::runtime_error("Capture failed");
+	}, 1, "traces");
+
+	runner.add("capture_trace_real", [&]() {
+		analyser->setDataTransferFormat(REAL);
+		if (analyser->captureData().empty()) throw std::runtime_error("Capture failed");
+	}, 1, "traces");
+
+	/*
+		The same capture over the other transports: HiSLIP against a local stand-in, and the simulation in the same process, which leaves only
+		the work done by AnalyserObj itself
+	*/
+	SimulatedHiSLIPServer simulatedHiSLIPServer;
+	boost::scoped_ptr<AnalyserObj<double, HiSLIPTransport>> hislipAnalyser;
+
+	runner.add("capture_trace_real32_hislip", [&]() {
+		if (!hislipAnalyser) {
+			hislipAnalyser.reset(new AnalyserObj<double, HiSLIPTransport>(400e6, 3e9, 0, 5e3, SAMPLEPOINTS, SMIT, S21, REAL32, "127.0.0.1", simulatedHiSLIPServer.getPort()));
+		}
+		if (hislipAnalyser->captureData().empty()) throw std::runtime_error("Capture failed");
+	}, 1, "traces");
+
+	boost::scoped_ptr<AnalyserObj<double, SimulatedTransport>> inProcessAnalyser;
+
+	runner.add("capture_trace_real32_in_process", [&]() {
+		if (!inProcessAnalyser) {
+			inProcessAnalyser.reset(new AnalyserObj<double, SimulatedTransport>(400e6, 3e9, 0, 5e3, SAMPLEPOINTS, SMIT, S21, REAL32));
+		}
+		if (inProcessAnalyser->captureData().empty()) throw std::runtime_error("Capture failed");
+	}, 1, "traces");
+
+	MeasurementCube<double> cube;
+	cube.allocate(1, 1, SAMPLEPOINTS);
+
+	runner.add("capture_trace_into_cube_real32", [&]() {
+		analyser->setDataTransferFormat(REAL32);
+		if (!analyser->captureInto(cube.real(0, 0), cube.imag(0, 0))) throw std::runtime_error("Capture failed");
+	}, 1, "traces");
+
+	/*
+		Gain transfer calibration of a captured trace, in place in the cube
+	*/
+	GainCalibration calibration;
+	calibration.setTable(REFERENCE_GAIN, { 400e6, 1e9, 2e9, 3e9 }, { 6.5, 9.8, 13.1, 15.2 });
+	calibration.setTable(REFERENCE_MEASUREMENT, { 400e6, 3e9 }, { -32.0, -47.5 });
+	calibration.setTable(PATH_LOSS, { 400e6, 3e9 }, { 0.3, 1.1 });
+	calibration.prepare(400e6, 3e9, SAMPLEPOINTS);
+
+	runner.add("calibrate_trace_smit", [&]() {
+		calibration.apply(SMIT, cube.real(0, 0), cube.imag(0, 0));
+	}, SAMPLEPOINTS, "points");
+
+	runner.add("calibrate_trace_mlog", [&]() {
+		calibration.apply(MLOG, cube.real(0, 0), cube.imag(0, 0));
+	}, SAMPLEPOINTS, "points");
+
+#ifndef _WIN32
+	/*
+		End to end measurement of a cut through MeasurementSystem, with a simulated rotator
+	*/
+	SimulatedRotator simulatedRotator;
+	boost::scoped_ptr<MeasurementSystem> system;
+
+	runner.add("measure_cut_19_positions", [&]() {
+		if (!system) {
+			system.reset(new MeasurementSystem(new AnalyserObj<double>(400e6, 3e9, 0, 5e3, SAMPLEPOINTS, SMIT, S21, REAL32, "127.0.0.1", simulatedAnalyser.getPort()),
+				new SerialRotatorObj(1, 255, 5, simulatedRotator.getPortName(), 9600)));
+		}
+		if (!system->measureCut(0, 90)) throw std::runtime_error("Measurement failed");
+	}, 19, "positions");
+
+	/*
+		Both polarisations measured at every position, on a second receive port of the analyser (S21 and S31 from a single sweep) and through
+		a switch matrix which routes both polarisations to port 2 (a sweep per path, switching while the data is transferred)
+	*/
+	boost::scoped_ptr<MeasurementSystem> dualPortSystem;
+
+	runner.add("measure_cut_19_positions_dual_port", [&]() {
+		if (!dualPortSystem) {
+			dualPortSystem.reset(new MeasurementSystem(new AnalyserObj<double>(400e6, 3e9, 0, 5e3, SAMPLEPOINTS, SMIT, S21, REAL32, "127.0.0.1", simulatedAnalyser.getPort()),
+				new SerialRotatorObj(1, 255, 5, simulatedRotator.getPortName(), 9600)));
+		}
+		if (!dualPortSystem->measureCut(0, 90, { S21, S31 })) throw std::runtime_error("Measurement failed");
+	}, 19, "positions");
+
+	SimulatedSwitchMatrix simulatedSwitch;
+	boost::scoped_ptr<MeasurementSystem> switchedSystem;
+
+	runner.add("measure_cut_19_positions_switched", [&]() {
+		if (!switchedSystem) {
+			switchedSystem.reset(new MeasurementSystem(new AnalyserObj<double>(400e6, 3e9, 0, 5e3, SAMPLEPOINTS, SMIT, S21, REAL32, "127.0.0.1", simulatedAnalyser.getPort()),
+				new SerialRotatorObj(1, 255, 5, simulatedRotator.getPortName(), 9600)));
+			switchedSystem->setSwitchMatrix(new SerialSwitchMatrix(simulatedSwitch.getPortName(), 9600, 0));
+			switchedSystem->setSwitchRoute(S21, 1, S21);
+			switchedSystem->setSwitchRoute(S31, 2, S21);
+		}
+		if (!switchedSystem->measureCut(0, 90, { S21, S31 })) throw std::runtime_error("Measurement failed");
+	}, 19, "positions");
+
+	/*
+		The same measurement replayed from a capture file as fast as possible, so that only the work done on the computer is measured
+	*/
+	boost::scoped_ptr<CaptureReplayer> replayer;
+	boost::scoped_ptr<MeasurementSystem> replaySystem;
+
+	runner.add("replay_measure_cut_19_positions", [&]() {
+		if (!replayer) {
+			if (capturePath.empty()) {
+				// Two cuts are recorded so that the capture includes the move back to the start of the cut
+				capturePath = (workDir / "session.cmc").string();
+
+				TransportRecorder recorder;
+				recorder.open(capturePath);
+
+				MeasurementSystem recordedSystem(new AnalyserObj<double>(400e6, 3e9, 0, 5e3, SAMPLEPOINTS, SMIT, S21, REAL32, "127.0.0.1", simulatedAnalyser.getPort(), &recorder),
+					new SerialRotatorObj(1, 255, 5, simulatedRotator.getPortName(), 9600, &recorder));
+
+				for (int cut = 0; cut < 2; cut++) {
+					if (!recordedSystem.measureCut(0, 90)) throw std::runtime_error("Recording failed");
+				}
+			}
+
+			std::vector<CaptureRecord> records;
+			if (!readCapture(capturePath, records)) throw std::runtime_error("Unable to read the capture");
+
+			replayer.reset(new CaptureReplayer(records, FAST_REPLAY));
+			replaySystem.reset(new MeasurementSystem(new AnalyserObj<double>(400e6, 3e9, 0, 5e3, SAMPLEPOINTS, SMIT, S21, REAL32, "127.0.0.1", replayer->getAnalyserPort()),
+				new SerialRotatorObj(1, 255, 5, replayer->getRotatorPortName(), 9600)));
+		}
+		if (!replaySystem->measureCut(0, 90)) throw std::runtime_error("Measurement failed");
+		if (replayer->getUnmatchedCount() > 0) throw std::runtime_error("The measurement did not follow the capture");
+	}, 19, "positions");
+#endif
+
+	runner.run();
+
+	boost::filesystem::remove_all(workDir);
+
+	return runner.writeJSON(outputPath) ? 0 : 1;
+}
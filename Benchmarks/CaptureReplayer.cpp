@@ -0,0 +1,206 @@
+#include "CaptureReplayer.h"
+#include <iostream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+CaptureReplayer::CaptureReplayer(const std::vector<CaptureRecord> &records, ReplayMode mode) : m_mode(mode), m_unmatched(0), m_acceptor(m_ioservice) {
+	double requestTime[2] = { 0, 0 };
+
+	for (const CaptureRecord &record : records) {
+		std::vector<Exchange> &exchanges = m_exchanges[record.channel];
+
+		if (record.direction == TO_DEVICE) {
+			Exchange exchange;
+			exchange.request = record.data;
+			exchanges.push_back(exchange);
+			requestTime[record.channel] = record.time;
+		}
+		else if (!exchanges.empty()) {
+			// Bytes received before the first request cannot be replayed
+			Reply reply = { record.time - requestTime[record.channel], record.data };
+			exchanges.back().replies.push_back(reply);
+		}
+	}
+
+	m_cursor[ANALYSER_CHANNEL] = m_cursor[ROTATOR_CHANNEL] = 0;
+
+	boost::asio::ip::tcp::endpoint ep(boost::asio::ip::address::from_string("127.0.0.1"), 0);
+
+	m_acceptor.open(ep.protocol());
+	m_acceptor.bind(ep);
+	m_acceptor.listen();
+	m_port = m_acceptor.local_endpoint().port();
+
+	m_work.reset(new boost::asio::io_service::work(m_ioservice));
+
+	startAccept();
+
+	m_thread = boost::thread([this]() { m_ioservice.run(); });
+
+#ifndef _WIN32
+	m_master = posix_openpt(O_RDWR | O_NOCTTY);
+
+	if (m_master < 0 || grantpt(m_master) != 0 || unlockpt(m_master) != 0) {
+		throw std::runtime_error("Unable to create a pseudo terminal for the replayed rotator");
+	}
+
+	m_portName = ptsname(m_master);
+	m_running = true;
+
+	m_rotatorThread = boost::thread([this]() { runRotator(); });
+#endif
+}
+
+/*
+	Finds the next exchange of a channel with the given request, starting after the last exchange which was replayed and wrapping around to the
+	start of the capture. Returns nullptr if the request does not appear in the capture
+*/
+const CaptureReplayer::Exchange *CaptureReplayer::findExchange(CaptureChannel channel, const std::string &request) {
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	const std::vector<Exchange> &exchanges = m_exchanges[channel];
+
+	for (std::size_t i = 0; i < exchanges.size(); i++) {
+		std::size_t index = (m_cursor[channel] + i) % exchanges.size();
+
+		if (exchanges[index].request == request) {
+			m_cursor[channel] = index + 1;
+			return &exchanges[index];
+		}
+	}
+
+	if (m_unmatched++ == 0) {
+		std::cerr << "The replayed capture does not contain the request " << request << std::endl;
+	}
+
+	return nullptr;
+}
+
+/*
+	In real time mode, waits until the reply is due
+*/
+void CaptureReplayer::waitForReply(const Reply &reply, boost::chrono::steady_clock::time_point received) {
+	if (m_mode == REALTIME_REPLAY) {
+		boost::this_thread::sleep_until(received + boost::chrono::microseconds(static_cast<long long>(reply.delay * 1e6)));
+	}
+}
+
+void CaptureReplayer::startAccept() {
+	boost::shared_ptr<Session> session(new Session(m_ioservice));
+
+	m_acceptor.async_accept(session->socket, [this, session](const boost::system::error_code &ec) {
+		if (ec) {
+			return;
+		}
+
+		boost::system::error_code ignored;
+		session->socket.set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+
+		startRead(session);
+		startAccept();
+	});
+}
+
+/*
+	Reads the next command line from AnalyserObj, sends the replies recorded for it and waits for the next one
+*/
+void CaptureReplayer::startRead(boost::shared_ptr<Session> session) {
+	boost::asio::async_read_until(session->socket, session->request, '\n', [this, session](const boost::system::error_code &ec, std::size_t length) {
+		if (ec) {
+			return;
+		}
+
+		boost::chrono::steady_clock::time_point received = boost::chrono::steady_clock::now();
+
+		std::string line(boost::asio::buffer_cast<const char *>(session->request.data()), length);
+		session->request.consume(length);
+
+		if (const Exchange *exchange = findExchange(ANALYSER_CHANNEL, line)) {
+			for (const Reply &reply : exchange->replies) {
+				waitForReply(reply, received);
+
+				boost::system::error_code writeError;
+				boost::asio::write(session->socket, boost::asio::buffer(reply.data), writeError);
+
+				if (writeError) {
+					return;
+				}
+			}
+		}
+
+		startRead(session);
+	});
+}
+
+#ifndef _WIN32
+/*
+	Reads 5 byte frames from the pseudo terminal and sends the replies recorded for them until the replayer is destroyed
+*/
+void CaptureReplayer::runRotator() {
+	char frame[5];
+	int received = 0;
+
+	while (m_running) {
+		pollfd fd = { m_master, POLLIN, 0 };
+
+		if (poll(&fd, 1, 50) <= 0 || !(fd.revents & POLLIN)) {
+			continue;
+		}
+
+		ssize_t count = read(m_master, frame + received, sizeof(frame) - received);
+
+		if (count <= 0) {
+			continue;
+		}
+
+		received += static_cast<int>(count);
+
+		if (received < 5) {
+			continue;
+		}
+
+		received = 0;
+
+		boost::chrono::steady_clock::time_point receivedTime = boost::chrono::steady_clock::now();
+
+		if (const Exchange *exchange = findExchange(ROTATOR_CHANNEL, std::string(frame, sizeof(frame)))) {
+			for (const Reply &reply : exchange->replies) {
+				waitForReply(reply, receivedTime);
+
+				if (write(m_master, reply.data.data(), reply.data.size()) != static_cast<ssize_t>(reply.data.size())) {
+					return;
+				}
+			}
+		}
+	}
+}
+
+std::string CaptureReplayer::getRotatorPortName() {
+	return m_portName;
+}
+#endif
+
+int CaptureReplayer::getAnalyserPort() {
+	return m_port;
+}
+
+std::uint64_t CaptureReplayer::getUnmatchedCount() {
+	return m_unmatched;
+}
+
+CaptureReplayer::~CaptureReplayer() {
+#ifndef _WIN32
+	m_running = false;
+	m_rotatorThread.join();
+	close(m_master);
+#endif
+
+	m_ioservice.stop();
+	m_thread.join();
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "TransportCapture.h"
+#include <boost/asio.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+	How the replies of a capture are timed
+*/
+enum ReplayMode {
+	REALTIME_REPLAY, // Every reply is sent as long after its request as it was during the recorded session. The recorded delay includes the round trip
+	                 // of the link to the instrument, so the replayed session is slower by about one round trip of the local link per request
+	FAST_REPLAY // Every reply is sent as soon as its request has been received
+};
+
+/*
+	Fake instruments which replay a capture file recorded with TransportRecorder, so that a real chamber session can be repeated without the
+	instruments. The analyser is replayed on a local TCP port and the rotator on a pseudo terminal (POSIX only), in the same way as
+	SimulatedAnalyser and SimulatedRotator.
+	The capture is split into exchanges: a request sent to an instrument and the replies received before the next request. Each request received
+	by the replayer, i.e. a line for the analyser and a 5 byte frame for the rotator, is matched with the next exchange with the same request,
+	wrapping around to the start of the capture, so that repeating the recorded sequence of commands replays the session again.
+	Requests which do not appear in the capture are counted and get no reply.
+*/
+class CaptureReplayer {
+private:
+	/*
+		Bytes received from an instrument, with the time since the request they answered
+	*/
+	struct Reply {
+		double delay;
+		std::string data;
+	};
+
+	/*
+		A request sent to an instrument together with its replies
+	*/
+	struct Exchange {
+		std::string request;
+		std::vector<Reply> replies;
+	};
+
+	/*
+		State of the connection to AnalyserObj
+	*/
+	struct Session {
+		boost::asio::ip::tcp::socket socket;
+		boost::asio::streambuf request;
+
+		Session(boost::asio::io_service &ioservice) : socket(ioservice) {}
+	};
+
+	ReplayMode m_mode;
+	std::vector<Exchange> m_exchanges[2]; // The exchanges of each channel
+	std::size_t m_cursor[2]; // Index of the exchange after the last one which was replayed on each channel
+	boost::mutex m_mutex;
+	std::atomic<std::uint64_t> m_unmatched; // Number of requests which were not found in the capture
+
+	boost::asio::io_service m_ioservice;
+	boost::scoped_ptr<boost::asio::io_service::work> m_work;
+	boost::asio::ip::tcp::acceptor m_acceptor;
+	boost::thread m_thread;
+	int m_port;
+
+#ifndef _WIN32
+	int m_master; // File descriptor of the controlling side of the pseudo terminal
+	std::string m_portName; // Name of the device which SerialRotatorObj opens
+	std::atomic<bool> m_running;
+	boost::thread m_rotatorThread;
+
+	void runRotator();
+#endif
+
+	void startAccept();
+	void startRead(boost::shared_ptr<Session> session);
+	const Exchange *findExchange(CaptureChannel channel, const std::string &request);
+	void waitForReply(const Reply &reply, boost::chrono::steady_clock::time_point received);
+
+public:
+	CaptureReplayer(const std::vector<CaptureRecord> &records, ReplayMode mode = FAST_REPLAY);
+
+	int getAnalyserPort();
+#ifndef _WIN32
+	std::string getRotatorPortName();
+#endif
+	std::uint64_t getUnmatchedCount();
+
+	~CaptureReplayer();
+};
@@ -0,0 +1,69 @@
+#include "SimulatedAnalyser.h"
+
+SimulatedAnalyser::SimulatedAnalyser(long sweepMicroseconds) : m_acceptor(m_ioservice), m_simulation(sweepMicroseconds) {
+	boost::asio::ip::tcp::endpoint ep(boost::asio::ip::address::from_string("127.0.0.1"), 0);
+
+	m_acceptor.open(ep.protocol());
+	m_acceptor.bind(ep);
+	m_acceptor.listen();
+	m_port = m_acceptor.local_endpoint().port();
+
+	m_work.reset(new boost::asio::io_service::work(m_ioservice));
+
+	startAccept();
+
+	m_thread = boost::thread([this]() { m_ioservice.run(); });
+}
+
+void SimulatedAnalyser::startAccept() {
+	boost::shared_ptr<Session> session(new Session(m_ioservice));
+
+	m_acceptor.async_accept(session->socket, [this, session](const boost::system::error_code &ec) {
+		if (ec) {
+			return;
+		}
+
+		boost::system::error_code ignored;
+		session->socket.set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+
+		startRead(session);
+		startAccept();
+	});
+}
+
+/*
+	Reads the next command line, answers it and waits for the next one
+*/
+void SimulatedAnalyser::startRead(boost::shared_ptr<Session> session) {
+	boost::asio::async_read_until(session->socket, session->request, '\n', [this, session](const boost::system::error_code &ec, std::size_t length) {
+		if (ec) {
+			return;
+		}
+
+		std::string line(boost::asio::buffer_cast<const char *>(session->request.data()), length - 1);
+		session->request.consume(length);
+
+		session->reply.clear();
+		m_simulation.handleLine(line, session->reply);
+
+		if (session->reply.empty()) {
+			startRead(session);
+			return;
+		}
+
+		boost::asio::async_write(session->socket, boost::asio::buffer(session->reply), [this, session](const boost::system::error_code &ec, std::size_t) {
+			if (!ec) {
+				startRead(session);
+			}
+		});
+	});
+}
+
+int SimulatedAnalyser::getPort() {
+	return m_port;
+}
+
+SimulatedAnalyser::~SimulatedAnalyser() {
+	m_ioservice.stop();
+	m_thread.join();
+}
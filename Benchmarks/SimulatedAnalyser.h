@@ -0,0 +1,44 @@
+#pragma once
+#include "AnalyserSimulation.h"
+#include <boost/asio.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <string>
+
+/*
+	Simulated network analyser used by the benchmarks. It listens on a local TCP port and answers the SCPI commands used by AnalyserObj with an
+	AnalyserSimulation, as the analyser does with a raw socket.
+	The sweep time can be set to model the time the real analyser takes to sweep.
+*/
+class SimulatedAnalyser {
+private:
+	/*
+		State of the connection to AnalyserObj
+	*/
+	struct Session {
+		boost::asio::ip::tcp::socket socket;
+		boost::asio::streambuf request;
+		std::string reply;
+
+		Session(boost::asio::io_service &ioservice) : socket(ioservice) {}
+	};
+
+	boost::asio::io_service m_ioservice;
+	boost::scoped_ptr<boost::asio::io_service::work> m_work;
+	boost::asio::ip::tcp::acceptor m_acceptor;
+	boost::thread m_thread;
+
+	int m_port;
+	AnalyserSimulation m_simulation;
+
+	void startAccept();
+	void startRead(boost::shared_ptr<Session> session);
+
+public:
+	SimulatedAnalyser(long sweepMicroseconds = 0);
+
+	int getPort();
+
+	~SimulatedAnalyser();
+};
@@ -0,0 +1,151 @@
+#include "SimulatedHiSLIPServer.h"
+
+SimulatedHiSLIPServer::SimulatedHiSLIPServer(long sweepMicroseconds) : m_acceptor(m_ioservice), m_nextSessionID(1), m_simulation(sweepMicroseconds), m_responseID(0), m_responseSent(false), m_newlineTerminated(true), m_statusQueryCount(0) {
+	boost::asio::ip::tcp::endpoint ep(boost::asio::ip::address::from_string("127.0.0.1"), 0);
+
+	m_acceptor.open(ep.protocol());
+	m_acceptor.bind(ep);
+	m_acceptor.listen();
+	m_port = m_acceptor.local_endpoint().port();
+
+	m_work.reset(new boost::asio::io_service::work(m_ioservice));
+
+	startAccept();
+
+	m_thread = boost::thread([this]() { m_ioservice.run(); });
+}
+
+void SimulatedHiSLIPServer::startAccept() {
+	boost::shared_ptr<Session> session(new Session(m_ioservice));
+
+	m_acceptor.async_accept(session->socket, [this, session](const boost::system::error_code &ec) {
+		if (ec) {
+			return;
+		}
+
+		boost::system::error_code ignored;
+		session->socket.set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+
+		startRead(session);
+		startAccept();
+	});
+}
+
+/*
+	Reads the next message, answers it and waits for the next one
+*/
+void SimulatedHiSLIPServer::startRead(boost::shared_ptr<Session> session) {
+	boost::asio::async_read(session->socket, boost::asio::buffer(session->header), [this, session](const boost::system::error_code &ec, std::size_t) {
+		HiSLIPHeader header;
+
+		if (ec || !header.decode(session->header)) {
+			return;
+		}
+
+		session->payload.resize(static_cast<std::size_t>(header.payloadLength));
+
+		boost::asio::async_read(session->socket, boost::asio::buffer(&session->payload[0], session->payload.size()), [this, session, header](const boost::system::error_code &ec, std::size_t) {
+			if (ec) {
+				return;
+			}
+
+			session->reply.clear();
+			handleMessage(session, header);
+
+			if (session->reply.empty()) {
+				startRead(session);
+				return;
+			}
+
+			boost::asio::async_write(session->socket, boost::asio::buffer(session->reply), [this, session](const boost::system::error_code &ec, std::size_t) {
+				if (!ec) {
+					startRead(session);
+				}
+			});
+		});
+	});
+}
+
+void SimulatedHiSLIPServer::handleMessage(boost::shared_ptr<Session> session, const HiSLIPHeader &header) {
+	switch (header.messageType) {
+	case HISLIP_INITIALIZE:
+		// Protocol version 1.0 without overlapped mode, and a new session ID
+		appendMessage(session->reply, HiSLIPHeader(HISLIP_INITIALIZE_RESPONSE, 0, (0x0100 << 16) | m_nextSessionID++));
+		break;
+	case HISLIP_ASYNC_INITIALIZE:
+		appendMessage(session->reply, HiSLIPHeader(HISLIP_ASYNC_INITIALIZE_RESPONSE, 0, ('S' << 8) | 'I'));
+		break;
+	case HISLIP_ASYNC_MAXIMUM_MESSAGE_SIZE:
+		appendMessage(session->reply, HiSLIPHeader(HISLIP_ASYNC_MAXIMUM_MESSAGE_SIZE_RESPONSE, 0, 0, 8), std::string("\0\0\0\0\0\x10\0\0", 8));
+		break;
+	case HISLIP_ASYNC_STATUS_QUERY:
+		// The status byte is sent as the control code
+		appendMessage(session->reply, HiSLIPHeader(HISLIP_ASYNC_STATUS_RESPONSE, (m_responseSent && m_responseID == header.messageParameter) ? 0x10 : 0));
+		m_statusQueryCount++;
+		break;
+	case HISLIP_DATA:
+		session->command += session->payload;
+		break;
+	case HISLIP_DATA_END: {
+		// The DataEnd message ends the command, the newline is optional
+		session->command += session->payload;
+
+		std::string lines;
+		std::size_t lineStart = 0;
+
+		while (lineStart < session->command.size()) {
+			std::size_t lineEnd = session->command.find('\n', lineStart);
+
+			if (lineEnd == std::string::npos) {
+				lineEnd = session->command.size();
+			}
+
+			m_simulation.handleLine(session->command.substr(lineStart, lineEnd - lineStart), lines);
+			lineStart = lineEnd + 1;
+		}
+
+		session->command.clear();
+
+		if (!m_newlineTerminated && !lines.empty() && lines.back() == '\n') {
+			lines.pop_back();
+		}
+
+		if (!lines.empty()) {
+			appendMessage(session->reply, HiSLIPHeader(HISLIP_DATA_END, 0, header.messageParameter, lines.size()), lines);
+			m_responseID = header.messageParameter;
+			m_responseSent = true;
+		}
+		break;
+	}
+	default: {
+		const std::string error = "Unrecognized message type";
+		appendMessage(session->reply, HiSLIPHeader(HISLIP_ERROR, 0, 0, error.size()), error);
+		break;
+	}
+	}
+}
+
+void SimulatedHiSLIPServer::appendMessage(std::string &reply, const HiSLIPHeader &header, const std::string &payload) {
+	char encoded[HiSLIPHeader::SIZE];
+	header.encode(encoded);
+
+	reply.append(encoded, sizeof(encoded));
+	reply += payload;
+}
+
+void SimulatedHiSLIPServer::setNewlineTerminated(bool terminated) {
+	m_newlineTerminated = terminated;
+}
+
+int SimulatedHiSLIPServer::getPort() {
+	return m_port;
+}
+
+int SimulatedHiSLIPServer::getStatusQueryCount() {
+	return m_statusQueryCount;
+}
+
+SimulatedHiSLIPServer::~SimulatedHiSLIPServer() {
+	m_ioservice.stop();
+	m_thread.join();
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "AnalyserSimulation.h"
+#include "HiSLIPTransport.h"
+#include <boost/asio.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/*
+	Local stand-in for an analyser with a HiSLIP server, used to test and benchmark HiSLIPTransport. It listens on a local TCP port and answers
+	the messages sent by HiSLIPTransport: the session set up on both channels, commands in Data and DataEnd messages, which are answered by an
+	AnalyserSimulation in a DataEnd message, and status queries on the asynchronous channel. Only the message available bit of the status byte
+	is simulated: it is set once the command named by the query has been answered, so a query which overtakes its command on the other channel
+	does not see the answer to an earlier one.
+	The newline at the end of the responses can be left out, as some analysers do since the DataEnd message already ends the response.
+*/
+class SimulatedHiSLIPServer {
+private:
+	/*
+		State of a connection, either the synchronous or the asynchronous channel of a session
+	*/
+	struct Session {
+		boost::asio::ip::tcp::socket socket;
+		char header[HiSLIPHeader::SIZE];
+		std::string payload;
+		std::string command; // Command which has been received in Data messages, waiting for the DataEnd message
+		std::string reply;
+
+		Session(boost::asio::io_service &ioservice) : socket(ioservice) {}
+	};
+
+	boost::asio::io_service m_ioservice;
+	boost::scoped_ptr<boost::asio::io_service::work> m_work;
+	boost::asio::ip::tcp::acceptor m_acceptor;
+	boost::thread m_thread;
+
+	int m_port;
+	std::uint16_t m_nextSessionID;
+	AnalyserSimulation m_simulation;
+	std::uint32_t m_responseID; // Message ID of the command which was answered last
+	bool m_responseSent; // Whether any command has been answered
+	std::atomic<bool> m_newlineTerminated; // Whether the responses keep the newline which the simulation ends them with
+	std::atomic<int> m_statusQueryCount;
+
+	void startAccept();
+	void startRead(boost::shared_ptr<Session> session);
+	void handleMessage(boost::shared_ptr<Session> session, const HiSLIPHeader &header);
+	void appendMessage(std::string &reply, const HiSLIPHeader &header, const std::string &payload = std::string());
+
+public:
+	SimulatedHiSLIPServer(long sweepMicroseconds = 0);
+
+	void setNewlineTerminated(bool terminated);
+
+	int getPort();
+	int getStatusQueryCount();
+
+	~SimulatedHiSLIPServer();
+};
@@ -0,0 +1,71 @@
+#include "SimulatedRotator.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdexcept>
+
+SimulatedRotator::SimulatedRotator(long moveMicroseconds) : m_moveMicroseconds(moveMicroseconds), m_running(true) {
+	m_master = posix_openpt(O_RDWR | O_NOCTTY);
+
+	if (m_master < 0 || grantpt(m_master) != 0 || unlockpt(m_master) != 0) {
+		throw std::runtime_error("Unable to create a pseudo terminal for the simulated rotator");
+	}
+
+	m_portName = ptsname(m_master);
+
+	m_thread = boost::thread([this]() { run(); });
+}
+
+/*
+	Reads commands from the pseudo terminal and answers them until the rotator is destroyed
+*/
+void SimulatedRotator::run() {
+	unsigned char command[5];
+	int received = 0;
+
+	while (m_running) {
+		pollfd fd = { m_master, POLLIN, 0 };
+
+		if (poll(&fd, 1, 50) <= 0 || !(fd.revents & POLLIN)) {
+			continue;
+		}
+
+		ssize_t count = read(m_master, command + received, sizeof(command) - received);
+
+		if (count <= 0) {
+			continue;
+		}
+
+		received += static_cast<int>(count);
+
+		if (received < 5) {
+			continue;
+		}
+
+		received = 0;
+
+		if (command[0] == 2 || command[0] == 3) {
+			if (m_moveMicroseconds > 0) {
+				boost::this_thread::sleep_for(boost::chrono::microseconds(m_moveMicroseconds));
+			}
+
+			if (write(m_master, command, 1) != 1) {
+				break;
+			}
+		}
+		else if (write(m_master, command, 5) != 5) {
+			break;
+		}
+	}
+}
+
+std::string SimulatedRotator::getPortName() {
+	return m_portName;
+}
+
+SimulatedRotator::~SimulatedRotator() {
+	m_running = false;
+	m_thread.join();
+	close(m_master);
+}
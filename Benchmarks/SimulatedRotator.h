@@ -0,0 +1,29 @@
+#pragma once
+#include <boost/thread/thread.hpp>
+#include <atomic>
+#include <string>
+
+/*
+	Simulated rotator controller used by the benchmarks. It creates a pseudo terminal which SerialRotatorObj can open as if it was a serial port,
+	and answers the 5 byte rotator commands: speed and acceleration commands are echoed back, and move commands are answered with the command byte
+	once the simulated move time has passed.
+	Pseudo terminals are only available on POSIX systems.
+*/
+class SimulatedRotator {
+private:
+	int m_master; // File descriptor of the controlling side of the pseudo terminal
+	std::string m_portName; // Name of the device which SerialRotatorObj opens
+	long m_moveMicroseconds;
+
+	std::atomic<bool> m_running;
+	boost::thread m_thread;
+
+	void run();
+
+public:
+	SimulatedRotator(long moveMicroseconds = 0);
+
+	std::string getPortName();
+
+	~SimulatedRotator();
+};
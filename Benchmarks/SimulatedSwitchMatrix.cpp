@@ -0,0 +1,97 @@
+#include "SimulatedSwitchMatrix.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <stdexcept>
+
+SimulatedSwitchMatrix::SimulatedSwitchMatrix(long switchMicroseconds) : m_switchMicroseconds(switchMicroseconds), m_path(-1), m_switchCount(0), m_failing(false), m_running(true) {
+	m_master = posix_openpt(O_RDWR | O_NOCTTY);
+
+	if (m_master < 0 || grantpt(m_master) != 0 || unlockpt(m_master) != 0) {
+		throw std::runtime_error("Unable to create a pseudo terminal for the simulated switch matrix");
+	}
+
+	m_portName = ptsname(m_master);
+
+	m_thread = boost::thread([this]() { run(); });
+}
+
+/*
+	Reads command lines from the pseudo terminal and answers them until the switch matrix is destroyed
+*/
+void SimulatedSwitchMatrix::run() {
+	std::string line;
+	char buffer[64];
+
+	while (m_running) {
+		pollfd fd = { m_master, POLLIN, 0 };
+
+		if (poll(&fd, 1, 50) <= 0 || !(fd.revents & POLLIN)) {
+			continue;
+		}
+
+		ssize_t count = read(m_master, buffer, sizeof(buffer));
+
+		if (count <= 0) {
+			continue;
+		}
+
+		for (ssize_t i = 0; i < count; i++) {
+			// The terminal may turn the newline into a carriage return, either ends the line
+			if (buffer[i] == '\n' || buffer[i] == '\r') {
+				if (!line.empty()) {
+					handleLine(line);
+				}
+
+				line.clear();
+			}
+			else {
+				line += buffer[i];
+			}
+		}
+	}
+}
+
+/*
+	Selects the path of a ":ROUT:CLOS (@<path>)" command and answers the *OPC? query which follows it
+*/
+void SimulatedSwitchMatrix::handleLine(const std::string &line) {
+	std::size_t channel = line.find("(@");
+
+	if (channel != std::string::npos) {
+		m_path = std::atoi(line.c_str() + channel + 2);
+		m_switchCount++;
+
+		if (m_switchMicroseconds > 0) {
+			boost::this_thread::sleep_for(boost::chrono::microseconds(m_switchMicroseconds));
+		}
+	}
+
+	if (line.find("*OPC?") != std::string::npos && write(m_master, m_failing ? "0\n" : "1\n", 2) != 2) {
+		m_running = false;
+	}
+}
+
+void SimulatedSwitchMatrix::setFailing(bool failing) {
+	m_failing = failing;
+}
+
+std::string SimulatedSwitchMatrix::getPortName() {
+	return m_portName;
+}
+
+int SimulatedSwitchMatrix::getPath() {
+	return m_path;
+}
+
+long SimulatedSwitchMatrix::getSwitchCount() {
+	return m_switchCount;
+}
+
+SimulatedSwitchMatrix::~SimulatedSwitchMatrix() {
+	m_running = false;
+	m_thread.join();
+	close(m_master);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <boost/thread/thread.hpp>
+#include <atomic>
+#include <string>
+
+/*
+	Simulated switch matrix controller used by the benchmarks. It creates a pseudo terminal which SerialSwitchMatrix can open as if it was a
+	serial port, and answers every command line ending in *OPC? with 1 once the simulated switching time has passed. The selected path is kept
+	so that the benchmarks can count the switch operations. The controller can be made to fail, in which case it answers 0 instead.
+	Pseudo terminals are only available on POSIX systems.
+*/
+class SimulatedSwitchMatrix {
+private:
+	int m_master; // File descriptor of the controlling side of the pseudo terminal
+	std::string m_portName; // Name of the device which SerialSwitchMatrix opens
+	long m_switchMicroseconds;
+
+	std::atomic<int> m_path;
+	std::atomic<long> m_switchCount;
+	std::atomic<bool> m_failing;
+	std::atomic<bool> m_running;
+	boost::thread m_thread;
+
+	void run();
+	void handleLine(const std::string &line);
+
+public:
+	SimulatedSwitchMatrix(long switchMicroseconds = 0);
+
+	void setFailing(bool failing);
+
+	std::string getPortName();
+	int getPath();
+	long getSwitchCount();
+
+	~SimulatedSwitchMatrix();
+};
@@ -0,0 +1,433 @@
+#include "SimulatedHiSLIPServer.h"
+#include "AnalyserObj.h"
+#include "SerialRotatorException.h"
+#include "SerialRotatorObj.h"
+#include "SerialSwitchMatrix.h"
+#include "SweepStreamServer.h"
+#include "TraceCodec.h"
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include "SimulatedRotator.h"
+#include "SimulatedSwitchMatrix.h"
+#endif
+
+/*
+	Tests of the parts of the acquisition path which the benchmarks rely on but do not check, run by ctest.
+	The instruments are replaced by the same simulations as in the benchmarks.
+	Usage: Tests [name], where only the tests with a name containing the given text are run
+*/
+
+static int failures = 0;
+
+/*
+	Records a failed check without stopping the test, so that all the failures of a test are reported at once
+*/
+static void check(bool condition, const char *expression, const char *file, int line) {
+	if (!condition) {
+		std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+		failures++;
+	}
+}
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+/*
+	A client which does not read the stream while traces are being published, with the smallest possible queue, must still receive whole frames
+	in order, ending with the last trace which was published
+*/
+static void testStreamSlowClient() {
+	const int samplePoints = 200000; // Large enough for the frames to fill the socket buffers
+	const int traces = 12;
+
+	SweepStreamServer server(0, 1, DROP_OLDEST);
+
+	boost::asio::io_service ioservice;
+	boost::asio::ip::tcp::socket client(ioservice);
+	client.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), static_cast<unsigned short>(server.getPort())));
+
+	for (int i = 0; i < 200 && server.getClientCount() == 0; i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+
+	CHECK(server.getClientCount() == 1);
+
+	MeasurementTrace trace;
+	trace.startFreq = 1e9;
+	trace.stopFreq = 2e9;
+	trace.parameter = S21;
+	trace.format = SMIT;
+	trace.data.resize(2 * samplePoints);
+
+	for (int t = 0; t < traces; t++) {
+		trace.angle = t;
+		std::fill(trace.data.begin(), trace.data.end(), static_cast<double>(t));
+		server.publish(trace);
+	}
+
+	// Give the server thread time to queue every trace while nothing is read
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+	std::vector<double> data(2 * samplePoints);
+	long long lastSequence = -1;
+	int received = 0;
+
+	while (lastSequence < traces - 1) {
+		StreamFrameHeader header;
+		boost::asio::read(client, boost::asio::buffer(&header, sizeof(header)));
+		boost::asio::read(client, boost::asio::buffer(data));
+
+		CHECK(std::memcmp(header.magic, "CMTS", 4) == 0);
+		CHECK(header.samplePoints == samplePoints);
+		CHECK(static_cast<long long>(header.sequence) > lastSequence);
+		CHECK(data.front() == header.angle && data.back() == header.angle);
+
+		lastSequence = static_cast<long long>(header.sequence);
+		received++;
+	}
+
+	CHECK(received < traces);
+	CHECK(server.getDroppedFrameCount() == static_cast<std::uint64_t>(traces - received));
+}
+
+/*
+	Creates a group of traces of the kinds which the codec handles differently: smooth data as measured with REAL64, the same data rounded to
+	floats as with REAL32, random bits which cannot be predicted, and smooth data mixed with special values
+*/
+static std::vector<double> makeCodecGroup(int kind, std::size_t traceCount, std::size_t samplePoints, unsigned int &seed) {
+	std::vector<double> data(2 * traceCount * samplePoints);
+
+	for (std::size_t i = 0; i < data.size(); i++) {
+		std::size_t trace = i / (2 * samplePoints);
+		double value = -20.0 + 10.0 * std::cos(0.01 * (i / 2) + 0.1 * trace) + ((i & 1) ? 3.0 : 0.0);
+
+		seed = seed * 1664525u + 1013904223u;
+
+		if (kind == 1) {
+			value = static_cast<float>(value);
+		}
+		else if (kind == 2) {
+			std::uint64_t bits = (static_cast<std::uint64_t>(seed) << 32) | (seed * 2654435761u);
+			std::memcpy(&value, &bits, sizeof(value));
+		}
+		else if (kind == 3 && (seed >> 28) == 0) {
+			const double specials[] = { std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity(),
+				-std::numeric_limits<double>::infinity(), -0.0, 0.0, std::numeric_limits<double>::denorm_min(), std::numeric_limits<double>::max() };
+			value = specials[(seed >> 8) % 7];
+		}
+
+		data[i] = value;
+	}
+
+	return data;
+}
+
+/*
+	Every group must decode to exactly the same bits as were encoded, including NaN and negative zero
+*/
+static void testCodecRoundTrip() {
+	const std::size_t sizes[][2] = { { 1, 1 }, { 1, 2 }, { 3, 7 }, { 5, 1601 }, { 16, 201 } };
+	unsigned int seed = 1;
+	TraceCodec codec;
+
+	for (int kind = 0; kind < 4; kind++) {
+		for (const std::size_t *size : sizes) {
+			std::vector<double> data = makeCodecGroup(kind, size[0], size[1], seed);
+			std::vector<char> encoded;
+			codec.encode(data.data(), size[0], size[1], encoded);
+
+			std::vector<double> decoded(data.size());
+			CHECK(codec.decode(encoded.data(), encoded.size(), size[0], size[1], decoded.data()));
+			CHECK(std::memcmp(decoded.data(), data.data(), data.size() * sizeof(double)) == 0);
+		}
+	}
+}
+
+/*
+	A truncated group must be rejected, and a corrupted group must not make the decoder read or write out of bounds
+*/
+static void testCodecCorruptInput() {
+	const std::size_t traceCount = 4;
+	const std::size_t samplePoints = 101;
+	unsigned int seed = 2;
+	TraceCodec codec;
+
+	for (int kind = 0; kind < 4; kind++) {
+		std::vector<double> data = makeCodecGroup(kind, traceCount, samplePoints, seed);
+		std::vector<char> encoded;
+		codec.encode(data.data(), traceCount, samplePoints, encoded);
+
+		std::vector<double> decoded(data.size());
+
+		for (std::size_t length = 0; length < encoded.size(); length++) {
+			// Copied so that a read past the truncated length is not hidden by the rest of the group
+			std::vector<char> truncated(encoded.begin(), encoded.begin() + length);
+			CHECK(!codec.decode(truncated.data(), truncated.size(), traceCount, samplePoints, decoded.data()));
+		}
+
+		for (int i = 0; i < 1000; i++) {
+			std::vector<char> corrupted = encoded;
+			seed = seed * 1664525u + 1013904223u;
+			corrupted[(seed >> 8) % corrupted.size()] ^= static_cast<char>(1 + (seed >> 24) % 255);
+
+			codec.decode(corrupted.data(), corrupted.size(), traceCount, samplePoints, decoded.data());
+		}
+	}
+}
+
+/*
+	Over HiSLIP, a sweep must be waited for by polling the status byte on the asynchronous channel, and only finish once the sweep has
+*/
+static void testHiSLIPSweepCompletion() {
+	const long sweepMicroseconds = 50000;
+	SimulatedHiSLIPServer server(sweepMicroseconds);
+	AnalyserObj<double, HiSLIPTransport> analyser(400e6, 3e9, 0, 5e3, 201, SMIT, S21, REAL32, "127.0.0.1", server.getPort());
+
+	int queriesBefore = server.getStatusQueryCount();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	CHECK(analyser.triggerSweep());
+	CHECK(std::chrono::steady_clock::now() - start >= std::chrono::microseconds(sweepMicroseconds));
+	CHECK(server.getStatusQueryCount() > queriesBefore);
+
+	std::vector<double> data = analyser.captureData();
+	CHECK(data.size() == 2 * 201);
+}
+
+/*
+	A response which the analyser ends with the DataEnd message alone, without a newline, must still be delivered
+*/
+static void testHiSLIPUnterminatedResponse() {
+	SimulatedHiSLIPServer server;
+	server.setNewlineTerminated(false);
+
+	HiSLIPTransport transport;
+	transport.open("127.0.0.1", server.getPort());
+	transport.send("*OPC?\n");
+
+	boost::asio::streambuf buffer;
+	std::size_t length = transport.fillUntil(buffer, '\n');
+
+	CHECK(length == 1);
+	CHECK(std::string(boost::asio::buffer_cast<const char *>(buffer.data()), buffer.size()) == "1");
+}
+
+#ifndef _WIN32
+/*
+	The position used for tracking must only change once the controller has confirmed a move, so a move which times out leaves it unchanged
+*/
+static void testRotatorFailedMove() {
+	SimulatedRotator simulatedRotator(200000);
+	SerialRotatorObj rotator(1, 255, 5, simulatedRotator.getPortName(), 9600);
+
+	rotator.rotateTo(10);
+	CHECK(rotator.getCurrentPosition() == 10);
+
+	rotator.getProtocolEngine().setMoveTimeout(20);
+	bool failed = false;
+
+	try {
+		rotator.rotateTo(20);
+	}
+	catch (SerialRotatorException &) {
+		failed = true;
+	}
+
+	CHECK(failed);
+	CHECK(rotator.getCurrentPosition() == 10);
+}
+
+/*
+	The late reply to a move which timed out must not be taken as the reply to the next move, which would then complete while the rotator is
+	still turning
+*/
+static void testRotatorLateReply() {
+	const long moveMicroseconds = 200000;
+	SimulatedRotator simulatedRotator(moveMicroseconds);
+	SerialRotatorObj rotator(1, 255, 5, simulatedRotator.getPortName(), 9600);
+
+	rotator.getProtocolEngine().setMoveTimeout(20);
+	bool failed = false;
+
+	try {
+		rotator.rotateTo(10);
+	}
+	catch (SerialRotatorException &) {
+		failed = true;
+	}
+
+	CHECK(failed);
+
+	// Let the late reply arrive
+	std::this_thread::sleep_for(std::chrono::microseconds(2 * moveMicroseconds));
+
+	rotator.getProtocolEngine().setMoveTimeout(1000);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	rotator.rotateTo(30);
+
+	CHECK(std::chrono::steady_clock::now() - start >= std::chrono::microseconds(moveMicroseconds));
+	CHECK(rotator.getCurrentPosition() == 30);
+}
+
+/*
+	Moves which are queued before the earlier ones have completed must be worked out from where the earlier ones end, not from the confirmed position
+*/
+static void testRotatorQueuedMoves() {
+	SimulatedRotator simulatedRotator(20000);
+	SerialRotatorObj rotator(1, 255, 5, simulatedRotator.getPortName(), 9600);
+
+	rotator.rotateTo(30);
+
+	std::future<void> first = rotator.rotateToAsync(40);
+	std::future<void> second = rotator.rotateToAsync(50);
+	first.get();
+	second.get();
+
+	CHECK(rotator.getCurrentPosition() == 50);
+
+	rotator.rotateTo(20);
+	CHECK(rotator.getCurrentPosition() == 20);
+}
+
+/*
+	A path which is already selected must not be switched again
+*/
+static void testSwitchPathCaching() {
+	SimulatedSwitchMatrix simulatedSwitch;
+	SerialSwitchMatrix switchMatrix(simulatedSwitch.getPortName(), 9600, 0);
+
+	switchMatrix.selectPath(1);
+	switchMatrix.selectPath(1);
+	switchMatrix.selectPath(2);
+	switchMatrix.selectPathAsync(2).get();
+
+	CHECK(simulatedSwitch.getSwitchCount() == 2);
+	CHECK(simulatedSwitch.getPath() == 2);
+	CHECK(switchMatrix.getPath() == 2);
+}
+
+/*
+	A selection which times out must fail and forget the path, and the late answer to it must not be taken as the answer to the next selection,
+	which would then complete before the relays have switched
+*/
+static void testSwitchTimeout() {
+	const long switchMicroseconds = 200000;
+	SimulatedSwitchMatrix simulatedSwitch(switchMicroseconds);
+	SerialSwitchMatrix switchMatrix(simulatedSwitch.getPortName(), 9600, 0);
+
+	switchMatrix.setCommandTimeout(20);
+	bool failed = false;
+
+	try {
+		switchMatrix.selectPath(1);
+	}
+	catch (boost::system::system_error &e) {
+		failed = (e.code() == boost::asio::error::timed_out);
+	}
+
+	CHECK(failed);
+	CHECK(switchMatrix.getPath() == -1);
+
+	// Let the late answer arrive
+	std::this_thread::sleep_for(std::chrono::microseconds(2 * switchMicroseconds));
+
+	switchMatrix.setCommandTimeout(1000);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	switchMatrix.selectPath(2);
+
+	CHECK(std::chrono::steady_clock::now() - start >= std::chrono::microseconds(switchMicroseconds));
+	CHECK(switchMatrix.getPath() == 2);
+	CHECK(simulatedSwitch.getPath() == 2);
+}
+
+/*
+	A path which the controller does not confirm must fail and be selected again the next time it is needed
+*/
+static void testSwitchFailure() {
+	SimulatedSwitchMatrix simulatedSwitch;
+	SerialSwitchMatrix switchMatrix(simulatedSwitch.getPortName(), 9600, 0);
+
+	simulatedSwitch.setFailing(true);
+	bool failed = false;
+
+	try {
+		switchMatrix.selectPath(1);
+	}
+	catch (boost::system::system_error &e) {
+		failed = (e.code() == boost::asio::error::invalid_argument);
+	}
+
+	CHECK(failed);
+	CHECK(switchMatrix.getPath() == -1);
+
+	simulatedSwitch.setFailing(false);
+	switchMatrix.selectPath(1);
+
+	CHECK(switchMatrix.getPath() == 1);
+	CHECK(simulatedSwitch.getSwitchCount() == 2);
+}
+#endif
+
+int main(int argc, char *argv[]) {
+	std::string filter = (argc > 1) ? argv[1] : "";
+
+	struct Test {
+		const char *name;
+		std::function<void()> function;
+	};
+
+	const Test tests[] = {
+		{ "stream_slow_client", testStreamSlowClient },
+		{ "codec_round_trip", testCodecRoundTrip },
+		{ "codec_corrupt_input", testCodecCorruptInput },
+		{ "hislip_sweep_completion", testHiSLIPSweepCompletion },
+		{ "hislip_unterminated_response", testHiSLIPUnterminatedResponse },
+#ifndef _WIN32
+		{ "rotator_failed_move", testRotatorFailedMove },
+		{ "rotator_late_reply", testRotatorLateReply },
+		{ "rotator_queued_moves", testRotatorQueuedMoves },
+		{ "switch_path_caching", testSwitchPathCaching },
+		{ "switch_timeout", testSwitchTimeout },
+		{ "switch_failure", testSwitchFailure },
+#endif
+	};
+
+	int run = 0;
+
+	for (const Test &test : tests) {
+		if (std::string(test.name).find(filter) == std::string::npos) {
+			continue;
+		}
+
+		int failuresBefore = failures;
+
+		try {
+			test.function();
+		}
+		catch (std::exception &e) {
+			std::cerr << test.name << ": exception: " << e.what() << std::endl;
+			failures++;
+		}
+
+		std::cout << ((failures == failuresBefore) ? "PASS " : "FAIL ") << test.name << std::endl;
+		run++;
+	}
+
+	if (run == 0) {
+		std::cerr << "No test matches " << filter << std::endl;
+		return 1;
+	}
+
+	return (failures == 0) ? 0 : 1;
+}
@@ -1,14 +1,19 @@
 #pragma once
 
-#include <boost\asio.hpp>
-#include <boost\asio\io_service.hpp>
-#include <boost\asio\ip\tcp.hpp>
-
-#include <boost\format.hpp>
-#include <boost\scoped_ptr.hpp>
-#include <boost\chrono.hpp>
-#include <boost\thread\thread.hpp>
+#include <boost/asio.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <boost/format.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/chrono.hpp>
+#include <boost/thread/thread.hpp>
+#include "AnalyserTransport.h"
+#include "HiSLIPTransport.h"
+#include "TransportCapture.h"
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
 #include <string>
 #include <vector>
 #include <map>
@@ -25,7 +30,8 @@ enum AnalyserParameter {
 	S11,
 	S12,
 	S21,
-	S22
+	S22,
+	S31 // Transmission to a third port, e.g. the second receive port of a dual polarised measurement
 };
 
 enum AnalyserDataTransferFormat {
@@ -51,14 +57,16 @@ const std::map<AnalyserParameter, std::string> AnalyserParameterToStringMap{
 	{S11, "S11"},
 	{S12, "S12"},
 	{S21, "S21"},
-	{S22, "S22"}
+	{S22, "S22"},
+	{S31, "S31"}
 };
 
 const std::map<std::string, AnalyserParameter> StringToAnalyserParameterMap{
 	{"S11", S11},
 	{"S12", S12},
 	{"S21", S21},
-	{"S22", S22}
+	{"S22", S22},
+	{"S31", S31}
 };
 
 const std::map<AnalyserDataTransferFormat, std::string> AnalyserDataTransferFormatToStringMap{
@@ -77,24 +85,28 @@ const std::map<AnalyserDataTransferFormat, int> AnalyserDataTransferFormatSize{
 };
 
 /*
-	Templated class for Analyser Object
+	Templated class for Analyser Object. T is the data type of the captured samples and Transport carries the commands and responses, e.g.
+	RawSocketTransport, HiSLIPTransport or SimulatedTransport (see AnalyserTransport.h)
 */
-template<class T>
+template<class T, class Transport = RawSocketTransport>
 class AnalyserObj {
 private:
 	// Class specific constants
-	const double MINFREQ = 100e3;
-	const double MAXFREQ = 8.5e9;
-	const double MINPOWERLVL = -55;
-	const double MAXPOWERLVL = 10;
-	const double MINIFBW = 2;
-	const double MAXIFBW = 500e3;
-	const int MINSAMPLEPOINTS = 2;
-	const int MAXSAMPLEPOINTS = 1601;
-	const int MINCHANNELS = 1;
-	const int MAXCHANNELS = 16;
-	const int MINTRACES = 1;
-	const int MAXTRACES = 16;
+	static constexpr double MINFREQ = 100e3;
+	static constexpr double MAXFREQ = 8.5e9;
+	static constexpr double MINPOWERLVL = -55;
+	static constexpr double MAXPOWERLVL = 10;
+	static constexpr double MINIFBW = 2;
+	static constexpr double MAXIFBW = 500e3;
+	static constexpr int MINSAMPLEPOINTS = 2;
+	static constexpr int MAXSAMPLEPOINTS = 1601;
+	static constexpr int MINCHANNELS = 1;
+	static constexpr int MAXCHANNELS = 16;
+	static constexpr int MINTRACES = 1;
+	static constexpr int MAXTRACES = 16;
+	static constexpr unsigned char MESSAGEAVAILABLEBIT = 0x10; // Bit of the status byte which is set while a response is waiting to be read
+	static constexpr int STATUSPOLLINTERVALMS = 2; // Time between two status queries while waiting for a response
+	static constexpr int STATUSPOLLTIMEOUTMS = 10000; // Time after which the status is no longer polled and the response is waited for instead
 
 	double m_startFreq;	// Start Frequency of the analyser
 	double m_stopFreq; // Stop Frequency of the analyser
@@ -112,12 +124,12 @@ private:
 
 	std::string m_IP; // The IP address of the analyser
 
-	std::vector<T> recvDataBuffer; // create a vector which will hold the received data
+	boost::asio::streambuf m_responseBuffer; // Holds bytes which have been received from the analyser but not yet consumed by a read
+	TransportRecorder *m_recorder; // Optional recorder of every byte exchanged with the analyser. Not owned by the object
 
-	boost::asio::io_service m_ioservice;
-	boost::scoped_ptr<boost::asio::ip::tcp::socket> m_socket; // Boost ASIO socket object which will be used for socket programming
+	Transport m_transport; // The connection to the analyser
 public:
-	AnalyserObj(double startFreq = 100e3, double stopFreq = 8.5e9, double powerLvl = 0, double IFBW = 5e3, int samplePoints = 1601, AnalyserFormat format = MLOG, AnalyserParameter parameter = S21, AnalyserDataTransferFormat dtf = REAL32, std::string IP = "192.168.20.200", int port = 23);
+	AnalyserObj(double startFreq = 100e3, double stopFreq = 8.5e9, double powerLvl = 0, double IFBW = 5e3, int samplePoints = 1601, AnalyserFormat format = MLOG, AnalyserParameter parameter = S21, AnalyserDataTransferFormat dtf = REAL32, std::string IP = "192.168.20.200", int port = Transport::DEFAULT_PORT, TransportRecorder *recorder = nullptr);
 
 	bool setStartFrequency(double startFreq = MINFREQ, int channel = 1);
 	bool setStopFrequency(double stopFreq = MAXFREQ, int channel = 1);
@@ -128,8 +140,10 @@ public:
 	bool setPort(int port = 22);
 	bool setFormat(AnalyserFormat format = MLOG, int channel = 1);
 	bool setParameter(AnalyserParameter parameter = S21, int channel = 1, int trace = 1);
+	bool setTraceCount(int traces = 1, int channel = 1);
 	bool setIP(std::string ip = "192.168.20.200");
 	bool setDataTransferFormat(AnalyserDataTransferFormat dtf = REAL32);
+	void setRecorder(TransportRecorder *recorder);
 
 	double getStartFreq();
 	double getStopFreq();
@@ -141,12 +155,26 @@ public:
 	AnalyserParameter getParameter();
 	AnalyserDataTransferFormat getDataTransferFormat();
 	std::string getIP();
+	Transport &getTransport();
 
 	std::vector<T> captureData(int channel = 1, int trace = 1);
+	bool captureInto(T *real, T *imag, int channel = 1, int trace = 1);
+	bool triggerSweep();
+	bool transferInto(T *real, T *imag, int channel = 1, int trace = 1);
 	bool sendCommand(std::string command, int retryCount = 5);
 	bool done();
+	bool readStatusByte(unsigned char &status);
+
+	static void decodeSamples(const char *block, std::size_t samples, AnalyserDataTransferFormat dtf, T *output);
+	static void decodeComplexSamples(const char *block, std::size_t points, AnalyserDataTransferFormat dtf, T *real, T *imag);
 
 	~AnalyserObj();
+
+private:
+	bool requestTraceBlock(int channel, int trace, std::size_t &blockLength);
+	void fillResponseBuffer(std::size_t bytes);
+	std::string readResponse();
+	void recordReceived(std::size_t previousSize);
 };
 
 /*
@@ -157,7 +185,7 @@ public:
 /*
 	Constructor for the AnalyserObj object
 */
-template<class T> AnalyserObj<T>::AnalyserObj(double startFreq, double stopFreq, double powerLvl, double IFBW, int samplePoints, AnalyserFormat format, AnalyserParameter parameter, AnalyserDataTransferFormat dtf, std::string IP, int port) {
+template<class T, class Transport> AnalyserObj<T, Transport>::AnalyserObj(double startFreq, double stopFreq, double powerLvl, double IFBW, int samplePoints, AnalyserFormat format, AnalyserParameter parameter, AnalyserDataTransferFormat dtf, std::string IP, int port, TransportRecorder *recorder) {
 	int retry_count = 5; // number of attempts to be made
 
 	this->m_startFreq = startFreq;
@@ -170,13 +198,10 @@ template<class T> AnalyserObj<T>::AnalyserObj(double startFreq, double stopFreq,
 	this->m_IP = IP;
 	this->m_port = port;
 	this->m_dataTransferFormat = dtf;
+	this->m_recorder = recorder;
 
 	try {
-		boost::asio::ip::tcp::endpoint ep(boost::asio::ip::address::from_string(m_IP), m_port); // define the end point to which one will be connecting
-
-		m_socket.reset(new boost::asio::ip::tcp::socket(m_ioservice, ep.protocol())); // initialise the socket object by resetting it.
-
-		m_socket->connect(ep); // connect to the endpoint
+		m_transport.open(m_IP, m_port); // connect to the analyser
 
 		boost::this_thread::sleep_for(boost::chrono::milliseconds(50)); // A small sleep delay to let things settle.
 
@@ -205,19 +230,24 @@ template<class T> AnalyserObj<T>::AnalyserObj(double startFreq, double stopFreq,
 /*
 	Method to send the commands to the analyser.
 */
-template<class T> bool AnalyserObj<T>::sendCommand(std::string command, int retryCount) {
-	int commandLength = command.length(); // Store the length of the command
-
+template<class T, class Transport> bool AnalyserObj<T, Transport>::sendCommand(std::string command, int retryCount) {
 	try {
 		// Here for debugging purposes
 		std::cout << "Command: " << command << std::endl;
 
+		// SCPI commands are terminated by a newline character
+		command += '\n';
+
 		// send the command and store the number of bytes sent
-		size_t charsSent = m_socket->send(boost::asio::buffer(command));
+		size_t charsSent = m_transport.send(command);
+
+		if (m_recorder) {
+			m_recorder->record(ANALYSER_CHANNEL, TO_DEVICE, command.data(), charsSent);
+		}
 
 		// Check whether the number of bytes corresponds to the command length. If not, something went wrong.
 		// #TODO: add a retry loop which attempts sending the command a number of times, until all the bytes have been sent.
-		if (charsSent == commandLength) {
+		if (charsSent == command.length()) {
 			std::cout << "Command sent successfully" << std::endl;
 			return true;
 		}
@@ -238,7 +268,7 @@ template<class T> bool AnalyserObj<T>::sendCommand(std::string command, int retr
 	Method for setting or changing the starting frequency of the analyser
 	There are simple checks in place to ensure that the data is within the supported ranges of the Analyser
 */
-template<class T> bool AnalyserObj<T>::setStartFrequency(double startFreq, int channel) {
+template<class T, class Transport> bool AnalyserObj<T, Transport>::setStartFrequency(double startFreq, int channel) {
 	// Check whether the input values are within the range of the analyser and assign values accordingly
 	if (startFreq < MINFREQ) {
 		m_startFreq = MINFREQ;
@@ -260,7 +290,7 @@ template<class T> bool AnalyserObj<T>::setStartFrequency(double startFreq, int c
 /*
 	Method used to set the stop frequeny of the analyser
 */
-template<class T> bool AnalyserObj<T>::setStopFrequency(double stopFreq, int channel) {
+template<class T, class Transport> bool AnalyserObj<T, Transport>::setStopFrequency(double stopFreq, int channel) {
 	// Check whether the input values are within the range of the analyser. Assign values accordingly.
 	if (stopFreq < MINFREQ) {
 		m_stopFreq = MINFREQ;
@@ -282,7 +312,7 @@ template<class T> bool AnalyserObj<T>::setStopFrequency(double stopFreq, int cha
 /*
 	Method used to set the frequency range across which measurements will take place by passing the start and stop frequencies 
 */
-template<class T> bool AnalyserObj<T>::setFrequencyRange(double startFreq, double stopFreq, int channel) {
+template<class T, class Transport> bool AnalyserObj<T, Transport>::setFrequencyRange(double startFreq, double stopFreq, int channel) {
 	// Check whether the starting frequency is within the bounds of the analyser and assign values accordingly
 	if (startFreq < MINFREQ) {
 		m_startFreq = MINFREQ;
@@ -314,7 +344,7 @@ template<class T> bool AnalyserObj<T>::setFrequencyRange(double startFreq, doubl
 /*
 	Method to set or change the transmitted power level of the analyser
 */
-template<class T> bool AnalyserObj<T>::setPowerLvl(double powerLvl, int port) {
+template<class T, class Transport> bool AnalyserObj<T, Transport>::setPowerLvl(double powerLvl, int port) {
 	if (powerLvl < MINPOWERLVL) {
 		m_powerLvl = MINPOWERLVL;
 	}
@@ -334,7 +364,7 @@ template<class T> bool AnalyserObj<T>::setPowerLvl(double powerLvl, int port) {
 /*
 	Method to set of change the IFBW of the analyser
 */
-template<class T> bool AnalyserObj<T>::setIFBW(double IFBW, int channel) {
+template<class T, class Transport> bool AnalyserObj<T, Transport>::setIFBW(double IFBW, int channel) {
 	if (IFBW < MINIFBW) {
 		m_IFBW = MINIFBW;
 	}
@@ -352,7 +382,7 @@ template<class T> bool AnalyserObj<T>::setIFBW(double IFBW, int channel) {
 /*
 	Method to set or change the number of sample points taken by the analyser
 */
-template<class T> bool AnalyserObj<T>::setSamplePoints(int samplePoints, int channel) {
+template<class T, class Transport> bool AnalyserObj<T, Transport>::setSamplePoints(int samplePoints, int channel) {
 	if (samplePoints < MINSAMPLEPOINTS) {
 		m_samplePoints = MINSAMPLEPOINTS;
 	}
@@ -371,21 +401,15 @@ template<class T> bool AnalyserObj<T>::setSamplePoints(int samplePoints, int cha
 /*
 	Method used to set or change he current port number
 */
-template<class T> bool AnalyserObj<T>::setPort(int port) {
+template<class T, class Transport> bool AnalyserObj<T, Transport>::setPort(int port) {
 	try {
-		// Define a new endpoint with the new port number
-		boost::asio::ip::tcp::endpoint ep(boost::asio::ip::address_v4::from_string(m_IP), port);
-
-		// Check whether a socket has already been created.
-		if (m_socket->is_open()) {
-			// If a socket exists, close it and reconnect to the new en point
-			m_socket->close();
-			m_socket->connect(ep);
-		}
-		else {
-			// Otherwise, if a socket connection hasn't been made, then connect to the endpoint
-			m_socket->connect(ep);
-		}
+		// Connect to the new port. The transport closes the previous connection if there is one
+		m_transport.open(m_IP, port);
+		m_responseBuffer.consume(m_responseBuffer.size());
+
+		m_port = port;
+
+		return true;
 	}
 	catch (boost::system::system_error &e) {
 		std::cerr << "An error has occurred whilst attempting to change the port of the Analyser Object" << std::endl;
@@ -399,7 +423,7 @@ template<class T> bool AnalyserObj<T>::setPort(int port) {
 /*
 	Method used to set the output format of the S-parameter data measured by the analyser
 */
-template<class T> bool AnalyserObj<T>::setFormat(AnalyserFormat format, int channel) {
+template<class T, class Transport> bool AnalyserObj<T, Transport>::setFormat(AnalyserFormat format, int channel) {
 	if (format < 0) {
 		m_format = MLOG;
 	}
@@ -418,12 +442,12 @@ template<class T> bool AnalyserObj<T>::setFormat(AnalyserFormat format, int chan
 /* 
 	Method to set or change the S-parameter which you wish to measure on the analyser
 */
-template<class T> bool AnalyserObj<T>::setParameter(AnalyserParameter parameter, int channel, int trace) {
+template<class T, class Transport> bool AnalyserObj<T, Transport>::setParameter(AnalyserParameter parameter, int channel, int trace) {
 	if (parameter < 0) {
 		m_parameter = S11;
 	}
-	else if (parameter > 3) {
-		m_parameter = S22;
+	else if (parameter > S31) {
+		m_parameter = S31;
 	}
 	else {
 		m_parameter = parameter;
@@ -434,24 +458,33 @@ template<class T> bool AnalyserObj<T>::setParameter(AnalyserParameter parameter,
 	return sendCommand(command);
 }
 
+/*
+	Method to set the number of traces of a channel. Every trace measures the parameter given to setParameter() for its trace number, and a
+	single sweep measures all the traces of the channel, which can then be transferred one by one with transferInto()
+*/
+template<class T, class Transport> bool AnalyserObj<T, Transport>::setTraceCount(int traces, int channel) {
+	if (traces < MINTRACES) {
+		traces = MINTRACES;
+	}
+	else if (traces > MAXTRACES) {
+		traces = MAXTRACES;
+	}
+
+	return sendCommand(boost::str(boost::format{ ":CALC%d:PAR:COUN %d" } % channel % traces));
+}
+
 /*
  Method to set or change the IP address which points to the analyser
 */
-template<class T> bool AnalyserObj<T>::setIP(std::string ip) {
+template<class T, class Transport> bool AnalyserObj<T, Transport>::setIP(std::string ip) {
 	try {
-		// Create and object which holds the information for the endpoint which we wish to connect to
-		boost::asio::ip::tcp::endpoint ep(boost::asio::ip::address::from_string(ip), m_port);
-
-		// Check whether a socket has been opened already
-		if (m_socket->is_open()) {
-			// If a socket is already open, close the socket and reconnect using the new endpoint data
-			m_socket->close();
-			m_socket->connect(ep);
-		}
-		else {
-			// Otherwise, just connect to the enpoint
-			m_socket->connect(ep);
-		}
+		// Connect to the new address. The transport closes the previous connection if there is one
+		m_transport.open(ip, m_port);
+		m_responseBuffer.consume(m_responseBuffer.size());
+
+		m_IP = ip;
+
+		return true;
 	}
 	catch (boost::system::system_error &e) {
 		std::cerr << "There was an error attempting to close the socket" << std::endl;
@@ -466,7 +499,7 @@ template<class T> bool AnalyserObj<T>::setIP(std::string ip) {
 	Method to set or change the Data Transfer Format of the analyser. The Data Transfer Format dictates the data format used by the analyser
 	to send data to the computer. It is important to know what the data format is, as this allows one to easily calculate the amount of data to expect
 */
-template<class T> bool AnalyserObj<T>::setDataTransferFormat(AnalyserDataTransferFormat dtf) {
+template<class T, class Transport> bool AnalyserObj<T, Transport>::setDataTransferFormat(AnalyserDataTransferFormat dtf) {
 	if (dtf < 0) {
 		m_dataTransferFormat = REAL;
 	}
@@ -478,110 +511,327 @@ template<class T> bool AnalyserObj<T>::setDataTransferFormat(AnalyserDataTransfe
 	}
 
 
-	std::string command = boost::str(boost::format( ":FORM:DATA %s" ) % AnalyserDataTransferFormatToStringMap.at(m_dataTransferFormat));
+	// The byte order is swapped so that the binary data arrives in the little endian order used by the computer
+	std::string command = boost::str(boost::format( ":FORM:DATA %s;:FORM:BORD SWAP" ) % AnalyserDataTransferFormatToStringMap.at(m_dataTransferFormat));
 
 	return sendCommand(command);
 }
 
 /*
-	Method used to request data from the analyser and return a vector containing the received data.
+	Method which triggers a single sweep and waits for the analyser to finish it. The sweep measures all the traces of the channel
 */
-template<class T> std::vector<T> AnalyserObj<T>::captureData(int channel, int trace) {
-	std::string header;
-	int samplesReceived = 0;
-	int totalSamplesReceived = 0;
-
+template<class T, class Transport> bool AnalyserObj<T, Transport>::triggerSweep() {
 	// Tell the analyser to wait for an external trigger to request data
-	// If the command fails, just return an empty vector
 	if (!sendCommand(":TRIG:SOUR EXT")) {
-		return{};
+		return false;
 	}
 
 	// Send a command to the analyser requesting that it captures a single sweep and then sends the data to the computer
 	if (!sendCommand(":TRIG:SING")) {
-		return{};
+		return false;
 	}
 
 	// Wait for the analyser to finish
 	while (!done());
 
-	// Loop until all the sampled data has been received. The amount of sampled data which we expect is equal to the number of sample points times 2.
-	// The reason for this is because all the data return is sent as complex data, even if there is no complex component. 
-	while (totalSamplesReceived < (2 * m_samplePoints)) {
-		// First it is necessary to process the header of the received data.
-		// The header tells us how much information we've received from the analyser, thus we can use this information to determine whether we have received all the data or not. 
-		// #TODO: If the correct amount of data is not received, retry.
-		m_socket->receive(boost::asio::buffer(header, 8));
-		std::stringstream(header) >> samplesReceived;
+	return true;
+}
+
+/*
+	Method which requests the formatted data of a trace from the last sweep. On success, the binary data block and the newline which terminates
+	it are waiting in the response buffer, and blockLength holds the number of data bytes. The caller must consume blockLength + 1 bytes.
+*/
+template<class T, class Transport> bool AnalyserObj<T, Transport>::requestTraceBlock(int channel, int trace, std::size_t &blockLength) {
+	const std::size_t sampleSize = AnalyserDataTransferFormatSize.at(m_dataTransferFormat);
+	const std::size_t expectedSamples = 2 * static_cast<std::size_t>(m_samplePoints);
+
+	// Request the formatted data of the trace
+	if (!sendCommand(boost::str(boost::format{ ":CALC%d:TRAC%d:DATA:FDAT?" } % channel % trace))) {
+		return false;
+	}
+
+	// The data is sent as a binary block. The header of the block is a '#', followed by a single digit which gives the number of digits
+	// in the length field, followed by the length field itself which gives the number of data bytes which follow.
+	// Indefinite blocks (#0) are not used by the analyser for trace data and are rejected like any other malformed header
+	fillResponseBuffer(2);
+	const char *header = boost::asio::buffer_cast<const char *>(m_responseBuffer.data());
+
+	if (header[0] != '#' || header[1] < '1' || header[1] > '9') {
+		std::cerr << "The analyser did not reply with a binary data block" << std::endl;
+		return false;
+	}
+
+	std::size_t lengthDigits = header[1] - '0';
+	m_responseBuffer.consume(2);
+
+	fillResponseBuffer(lengthDigits);
+	const char *lengthField = boost::asio::buffer_cast<const char *>(m_responseBuffer.data());
+	blockLength = 0;
+
+	for (std::size_t i = 0; i < lengthDigits; i++) {
+		if (lengthField[i] < '0' || lengthField[i] > '9') {
+			std::cerr << "The length of the binary data block sent by the analyser is not a number" << std::endl;
+			return false;
+		}
+
+		blockLength = 10 * blockLength + (lengthField[i] - '0');
+	}
+
+	m_responseBuffer.consume(lengthDigits);
+
+	// The length of the block must match the settings, otherwise the data cannot be used. A block of a plausible size is still read and
+	// discarded so that the next response is read from the right place, a larger one is not read at all since its length cannot be trusted
+	if (blockLength != expectedSamples * sampleSize) {
+		std::cerr << "The analyser sent " << blockLength << " bytes, but " << expectedSamples * sampleSize << " bytes were expected" << std::endl;
+
+		if (blockLength <= 2 * static_cast<std::size_t>(MAXSAMPLEPOINTS) * sizeof(double)) {
+			fillResponseBuffer(blockLength + 1);
+			m_responseBuffer.consume(blockLength + 1);
+		}
+
+		return false;
+	}
+
+	// Read the block and the newline which terminates it
+	fillResponseBuffer(blockLength + 1);
+
+	return true;
+}
+
+/*
+	Method used to request data from the analyser and return a vector containing the received data.
+	The data is returned as interleaved real and imaginary values, i.e. 2 values for every sample point.
+	If the command fails, just return an empty vector
+*/
+template<class T, class Transport> std::vector<T> AnalyserObj<T, Transport>::captureData(int channel, int trace) {
+	std::size_t blockLength;
+
+	if (!triggerSweep() || !requestTraceBlock(channel, trace, blockLength)) {
+		return{};
+	}
+
+	// Convert the received samples to the data type of the object
+	std::size_t samplesReceived = blockLength / AnalyserDataTransferFormatSize.at(m_dataTransferFormat);
+	std::vector<T> data(samplesReceived);
+
+	decodeSamples(boost::asio::buffer_cast<const char *>(m_responseBuffer.data()), samplesReceived, m_dataTransferFormat, data.data());
+	m_responseBuffer.consume(blockLength + 1);
+
+	return data;
+}
+
+/*
+	Method used to capture a trace straight into memory supplied by the caller, e.g. the rows of a MeasurementCube, without allocating anything.
+	The real and imaginary values are written to separate arrays, which must each have room for getSamplePoints() values.
+	Returns false if the capture failed or if the analyser did not send exactly getSamplePoints() sample points, in which case nothing is written.
+*/
+template<class T, class Transport> bool AnalyserObj<T, Transport>::captureInto(T *real, T *imag, int channel, int trace) {
+	return triggerSweep() && transferInto(real, imag, channel, trace);
+}
 
-		samplesReceived /= dataSize[m_dataTransferFormat];
+/*
+	Method which transfers a trace of the last sweep into memory supplied by the caller, in the same way as captureInto() but without sweeping.
+	Used to transfer several traces which were measured by a single sweep.
+*/
+template<class T, class Transport> bool AnalyserObj<T, Transport>::transferInto(T *real, T *imag, int channel, int trace) {
+	std::size_t blockLength;
 
-		m_socket->receive(boost::asio::buffer(dataBuffer, samplesReceived));
+	if (!requestTraceBlock(channel, trace, blockLength)) {
+		return false;
 	}
 
-	return dataBuffer;
+	// requestTraceBlock() has already checked that the block holds exactly getSamplePoints() sample points
+	decodeComplexSamples(boost::asio::buffer_cast<const char *>(m_responseBuffer.data()), static_cast<std::size_t>(m_samplePoints), m_dataTransferFormat, real, imag);
+	m_responseBuffer.consume(blockLength + 1);
+
+	return true;
+}
+
+/*
+	Method which converts the samples of a binary data block received from the analyser to the data type of the object.
+	The analyser is set up to send the data in little endian byte order, which is the byte order of the computer, so the samples only need to be copied.
+*/
+template<class T, class Transport> void AnalyserObj<T, Transport>::decodeSamples(const char *block, std::size_t samples, AnalyserDataTransferFormat dtf, T *output) {
+	if (dtf == REAL32) {
+		for (std::size_t i = 0; i < samples; i++) {
+			float sample;
+			std::memcpy(&sample, block + i * sizeof(float), sizeof(float));
+			output[i] = static_cast<T>(sample);
+		}
+	}
+	else {
+		for (std::size_t i = 0; i < samples; i++) {
+			double sample;
+			std::memcpy(&sample, block + i * sizeof(double), sizeof(double));
+			output[i] = static_cast<T>(sample);
+		}
+	}
+}
+
+/*
+	Method which converts the interleaved real and imaginary samples of a binary data block to the data type of the object, writing the real
+	and imaginary values to separate arrays.
+*/
+template<class T, class Transport> void AnalyserObj<T, Transport>::decodeComplexSamples(const char *block, std::size_t points, AnalyserDataTransferFormat dtf, T *real, T *imag) {
+	if (dtf == REAL32) {
+		for (std::size_t i = 0; i < points; i++) {
+			float sample[2];
+			std::memcpy(sample, block + 2 * i * sizeof(float), sizeof(sample));
+			real[i] = static_cast<T>(sample[0]);
+			imag[i] = static_cast<T>(sample[1]);
+		}
+	}
+	else {
+		for (std::size_t i = 0; i < points; i++) {
+			double sample[2];
+			std::memcpy(sample, block + 2 * i * sizeof(double), sizeof(sample));
+			real[i] = static_cast<T>(sample[0]);
+			imag[i] = static_cast<T>(sample[1]);
+		}
+	}
 }
 
 /*
 	Method for checking whether the analyser has finished processing the last command sent to it
 */
-template<class T> bool AnalyserObj<T>::done() {
-	long int response = 0;
-	
+template<class T, class Transport> bool AnalyserObj<T, Transport>::done() {
 	// The *OPC? command queries the analyser to check whether the last command has been processed. The received response is +1
-	this->sendCommand("*OPC?");
-	m_socket->receive(boost::asio::buffer(&response, 1));
-	return (response == 1);
+	if (!this->sendCommand("*OPC?")) {
+		return false;
+	}
+
+	// On a transport with a status channel, the status byte is polled on that channel, which the analyser answers straight away, until the
+	// message available bit shows that the response has arrived. The polling is spaced out so that it does not flood the instrument, and it
+	// gives up after a while, e.g. for a very slow sweep or an analyser which never sets the bit, in which case the response is waited for
+	if (Transport::STATUS_CHANNEL) {
+		const boost::chrono::steady_clock::time_point deadline = boost::chrono::steady_clock::now() + boost::chrono::milliseconds(STATUSPOLLTIMEOUTMS);
+		unsigned char status;
+
+		while (m_transport.readStatusByte(status) && !(status & MESSAGEAVAILABLEBIT) && boost::chrono::steady_clock::now() < deadline) {
+			boost::this_thread::sleep_for(boost::chrono::milliseconds(STATUSPOLLINTERVALMS));
+		}
+	}
+
+	return (std::atoi(readResponse().c_str()) == 1);
+}
+
+/*
+	Method which reads the status byte of the analyser. The transport reads it on a separate channel if it has one, otherwise it is queried
+	with *STB? like any other command
+*/
+template<class T, class Transport> bool AnalyserObj<T, Transport>::readStatusByte(unsigned char &status) {
+	if (m_transport.readStatusByte(status)) {
+		return true;
+	}
+
+	if (!sendCommand("*STB?")) {
+		return false;
+	}
+
+	status = static_cast<unsigned char>(std::atoi(readResponse().c_str()));
+
+	return true;
 }
 
 /*
-	Destructor method for the analyser object. This method is called when the object goes out of scope. This method is needed to close the socket and prevent unexpected behaviour
+	Method which makes sure that at least the requested number of bytes are waiting in the response buffer, reading from the analyser if necessary
 */
-template<class T> AnalyserObj<T>::~AnalyserObj() {
-	if (m_socket->is_open())
-		m_socket->close();
+template<class T, class Transport> void AnalyserObj<T, Transport>::fillResponseBuffer(std::size_t bytes) {
+	std::size_t previousSize = m_responseBuffer.size();
+
+	if (previousSize < bytes) {
+		m_transport.fill(m_responseBuffer, bytes);
+		recordReceived(previousSize);
+	}
+}
+
+/*
+	Method which reads a single newline terminated response from the analyser. The newline is not included in the returned string.
+	A transport which marks the end of a response may deliver it without the newline.
+*/
+template<class T, class Transport> std::string AnalyserObj<T, Transport>::readResponse() {
+	std::size_t previousSize = m_responseBuffer.size();
+	std::size_t length = m_transport.fillUntil(m_responseBuffer, '\n');
+	recordReceived(previousSize);
+
+	const char *begin = boost::asio::buffer_cast<const char *>(m_responseBuffer.data());
+	std::string response(begin, (length > 0 && begin[length - 1] == '\n') ? length - 1 : length);
+	m_responseBuffer.consume(length);
+
+	return response;
+}
+
+/*
+	Method which passes the bytes which were added to the response buffer by the last read to the recorder, if there is one
+*/
+template<class T, class Transport> void AnalyserObj<T, Transport>::recordReceived(std::size_t previousSize) {
+	if (m_recorder && m_responseBuffer.size() > previousSize) {
+		m_recorder->record(ANALYSER_CHANNEL, FROM_DEVICE, boost::asio::buffer_cast<const char *>(m_responseBuffer.data()) + previousSize, m_responseBuffer.size() - previousSize);
+	}
+}
+
+/*
+	Method which sets the recorder which is given every byte sent to and received from the analyser. Passing a nullptr stops the recording.
+	The recorder is not owned by the analyser object and must outlive it, or be removed first.
+*/
+template<class T, class Transport> void AnalyserObj<T, Transport>::setRecorder(TransportRecorder *recorder) {
+	m_recorder = recorder;
+}
+
+/*
+	Destructor method for the analyser object. This method is called when the object goes out of scope. This method is needed to close the connection and prevent unexpected behaviour
+*/
+template<class T, class Transport> AnalyserObj<T, Transport>::~AnalyserObj() {
+	m_transport.close();
 }
 
 /*
 	Getter methods
 */
 
-template<class T> double AnalyserObj<T>::getStartFreq() {
+template<class T, class Transport> double AnalyserObj<T, Transport>::getStartFreq() {
 	return m_startFreq;
 }
 
-template<class T> double AnalyserObj<T>::getStopFreq() {
+template<class T, class Transport> double AnalyserObj<T, Transport>::getStopFreq() {
 	return m_stopFreq;
 }
 
-template<class T> double AnalyserObj<T>::getPowerLvl() {
+template<class T, class Transport> double AnalyserObj<T, Transport>::getPowerLvl() {
 	return m_powerLvl;
 }
 
-template<class T> double AnalyserObj<T>::getIFBW() {
+template<class T, class Transport> double AnalyserObj<T, Transport>::getIFBW() {
 	return m_IFBW;
 }
 
-template<class T> int AnalyserObj<T>::getSamplePoints() {
+template<class T, class Transport> int AnalyserObj<T, Transport>::getSamplePoints() {
 	return m_samplePoints;
 }
 
-template<class T> int AnalyserObj<T>::getPort() {
+template<class T, class Transport> int AnalyserObj<T, Transport>::getPort() {
 	return m_port;
 }
 
-template<class T> AnalyserFormat AnalyserObj<T>::getFormat() {
+template<class T, class Transport> AnalyserFormat AnalyserObj<T, Transport>::getFormat() {
 	return m_format;
 }
 
-template<class T> AnalyserParameter AnalyserObj<T>::getParameter() {
+template<class T, class Transport> AnalyserParameter AnalyserObj<T, Transport>::getParameter() {
 	return m_parameter;
 }
 
-template<class T> std::string AnalyserObj<T>::getIP() {
+template<class T, class Transport> std::string AnalyserObj<T, Transport>::getIP() {
 	return m_IP;
 }
 
-template<class T> AnalyserDataTransferFormat AnalyserObj<T>::getDataTransferFormat() {
+template<class T, class Transport> AnalyserDataTransferFormat AnalyserObj<T, Transport>::getDataTransferFormat() {
 	return m_dataTransferFormat;
-}
\ No newline at end of file
+}
+
+/*
+	Returns the transport, e.g. to set options of a HiSLIPTransport or the simulation of a SimulatedTransport
+*/
+template<class T, class Transport> Transport &AnalyserObj<T, Transport>::getTransport() {
+	return m_transport;
+}
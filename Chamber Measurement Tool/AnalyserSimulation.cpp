@@ -0,0 +1,84 @@
+#include "AnalyserSimulation.h"
+#include <boost/algorithm/string.hpp>
+#include <boost/chrono.hpp>
+#include <boost/thread/thread.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+AnalyserSimulation::AnalyserSimulation(long sweepMicroseconds) : m_samplePoints(1601), m_real32(false), m_sweepMicroseconds(sweepMicroseconds) {
+}
+
+/*
+	Answers a command line, without its newline, and appends the replies to reply. Several commands can be sent on one line, separated by semicolons
+*/
+void AnalyserSimulation::handleLine(const std::string &line, std::string &reply) {
+	std::vector<std::string> commands;
+	boost::split(commands, line, boost::is_any_of(";"));
+
+	for (const std::string &command : commands) {
+		handleCommand(command, reply);
+	}
+}
+
+void AnalyserSimulation::handleCommand(const std::string &command, std::string &reply) {
+	std::string upper = boost::to_upper_copy(command);
+
+	if (upper == "*OPC?") {
+		reply += "1\n";
+	}
+	else if (upper == "*STB?") {
+		reply += "0\n";
+	}
+	else if (upper.find(":SWE:POIN ") != std::string::npos) {
+		m_samplePoints = std::atoi(upper.substr(upper.find(' ') + 1).c_str());
+	}
+	else if (upper.find(":FORM:DATA ") != std::string::npos) {
+		m_real32 = (upper.find("REAL32") != std::string::npos);
+	}
+	else if (upper.find(":TRIG:SING") != std::string::npos) {
+		if (m_sweepMicroseconds > 0) {
+			boost::this_thread::sleep_for(boost::chrono::microseconds(m_sweepMicroseconds));
+		}
+	}
+	else if (upper.find(":DATA:FDAT?") != std::string::npos) {
+		appendTraceBlock(reply);
+	}
+}
+
+/*
+	Appends a binary block with a synthetic trace to the reply
+*/
+void AnalyserSimulation::appendTraceBlock(std::string &reply) {
+	std::size_t samples = 2 * static_cast<std::size_t>(m_samplePoints);
+	std::size_t sampleSize = m_real32 ? sizeof(float) : sizeof(double);
+	std::string length = std::to_string(samples * sampleSize);
+
+	reply += "#" + std::to_string(length.length()) + length;
+
+	std::size_t offset = reply.size();
+	reply.resize(offset + samples * sampleSize);
+
+	for (std::size_t i = 0; i < samples; i++) {
+		double value = -20.0 + 10.0 * std::sin(0.01 * i);
+
+		if (m_real32) {
+			float sample = static_cast<float>(value);
+			std::memcpy(&reply[offset + i * sampleSize], &sample, sizeof(sample));
+		}
+		else {
+			std::memcpy(&reply[offset + i * sampleSize], &value, sizeof(value));
+		}
+	}
+
+	reply += "\n";
+}
+
+void AnalyserSimulation::setSweepTime(long sweepMicroseconds) {
+	m_sweepMicroseconds = sweepMicroseconds;
+}
+
+long AnalyserSimulation::getSweepTime() {
+	return m_sweepMicroseconds;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+
+/*
+	Simulation of the network analyser which answers the SCPI commands used by AnalyserObj: *OPC? is answered with 1, *STB? with 0 and trace data
+	queries with a binary block in the requested data transfer format, holding a synthetic trace with the requested number of sample points.
+	All other commands are accepted and ignored. The sweep time can be set to model the time the real analyser takes to sweep.
+	The simulation only deals with text, it is used by SimulatedTransport in the same process and by the simulated instruments of the benchmarks
+	over the network.
+*/
+class AnalyserSimulation {
+private:
+	int m_samplePoints;
+	bool m_real32;
+	long m_sweepMicroseconds;
+
+	void handleCommand(const std::string &command, std::string &reply);
+	void appendTraceBlock(std::string &reply);
+
+public:
+	AnalyserSimulation(long sweepMicroseconds = 0);
+
+	void handleLine(const std::string &line, std::string &reply);
+
+	void setSweepTime(long sweepMicroseconds);
+	long getSweepTime();
+};
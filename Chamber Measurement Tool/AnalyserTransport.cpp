@@ -0,0 +1,131 @@
+#include "AnalyserTransport.h"
+#include <algorithm>
+
+RawSocketTransport::RawSocketTransport() : m_socket(m_ioservice) {
+}
+
+/*
+	Connects to the analyser, closing the previous connection if there is one
+*/
+void RawSocketTransport::open(const std::string &ip, int port) {
+	boost::asio::ip::tcp::endpoint ep(boost::asio::ip::address::from_string(ip), port);
+
+	if (m_socket.is_open()) {
+		m_socket.close();
+	}
+
+	m_socket.connect(ep);
+
+	// Commands are small writes which are each followed by a read. Without this option, every command after the first is held back until the
+	// analyser acknowledges the previous one, which it delays by up to 40 ms
+	m_socket.set_option(boost::asio::ip::tcp::no_delay(true));
+}
+
+void RawSocketTransport::close() {
+	if (m_socket.is_open()) {
+		m_socket.close();
+	}
+}
+
+bool RawSocketTransport::isOpen() {
+	return m_socket.is_open();
+}
+
+std::size_t RawSocketTransport::send(const std::string &data) {
+	return boost::asio::write(m_socket, boost::asio::buffer(data));
+}
+
+void RawSocketTransport::fill(boost::asio::streambuf &buffer, std::size_t size) {
+	if (buffer.size() < size) {
+		boost::asio::read(m_socket, buffer, boost::asio::transfer_exactly(size - buffer.size()));
+	}
+}
+
+std::size_t RawSocketTransport::fillUntil(boost::asio::streambuf &buffer, char delimiter) {
+	return boost::asio::read_until(m_socket, buffer, delimiter);
+}
+
+/*
+	A raw socket has no channel besides the one used for the commands
+*/
+bool RawSocketTransport::readStatusByte(unsigned char & /* status */) {
+	return false;
+}
+
+SimulatedTransport::SimulatedTransport() : m_open(false) {
+}
+
+void SimulatedTransport::open(const std::string & /* ip */, int /* port */) {
+	m_input.clear();
+	m_output.clear();
+	m_open = true;
+}
+
+void SimulatedTransport::close() {
+	m_open = false;
+}
+
+bool SimulatedTransport::isOpen() {
+	return m_open;
+}
+
+/*
+	Answers every complete command line in the data
+*/
+std::size_t SimulatedTransport::send(const std::string &data) {
+	if (!m_open) {
+		throw boost::system::system_error(boost::asio::error::not_connected);
+	}
+
+	m_input += data;
+
+	std::size_t lineEnd;
+
+	while ((lineEnd = m_input.find('\n')) != std::string::npos) {
+		m_simulation.handleLine(m_input.substr(0, lineEnd), m_output);
+		m_input.erase(0, lineEnd + 1);
+	}
+
+	return data.size();
+}
+
+void SimulatedTransport::moveOutput(boost::asio::streambuf &buffer) {
+	if (!m_output.empty()) {
+		buffer.commit(boost::asio::buffer_copy(buffer.prepare(m_output.size()), boost::asio::buffer(m_output)));
+		m_output.clear();
+	}
+}
+
+/*
+	All the responses are available as soon as the command has been sent, so waiting for more would never end. Asking for more than there is
+	fails in the same way as a connection which was closed by the analyser
+*/
+void SimulatedTransport::fill(boost::asio::streambuf &buffer, std::size_t size) {
+	moveOutput(buffer);
+
+	if (buffer.size() < size) {
+		throw boost::system::system_error(boost::asio::error::eof);
+	}
+}
+
+std::size_t SimulatedTransport::fillUntil(boost::asio::streambuf &buffer, char delimiter) {
+	moveOutput(buffer);
+
+	const char *begin = boost::asio::buffer_cast<const char *>(buffer.data());
+	const char *end = begin + buffer.size();
+	const char *found = std::find(begin, end, delimiter);
+
+	if (found == end) {
+		throw boost::system::system_error(boost::asio::error::eof);
+	}
+
+	return found - begin + 1;
+}
+
+bool SimulatedTransport::readStatusByte(unsigned char & /* status */) {
+	return false;
+}
+
+AnalyserSimulation &SimulatedTransport::getSimulation() {
+	return m_simulation;
+}
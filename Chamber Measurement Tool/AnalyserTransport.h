@@ -0,0 +1,74 @@
+#pragma once
+#include "AnalyserSimulation.h"
+#include <boost/asio.hpp>
+#include <string>
+
+/*
+	Transports which carry the SCPI commands and responses between AnalyserObj and the analyser. The transport is a template parameter of
+	AnalyserObj, so the calls are resolved at compile time and the setter, capture and done logic is shared by all of them.
+	A transport provides:
+	- DEFAULT_PORT, the port used when none is given
+	- STATUS_CHANNEL, whether the status byte can be read on a channel of its own, in which case done() waits for the analyser on that channel
+	- open(ip, port) and close(), which throw boost::system::system_error if the connection fails, and isOpen()
+	- send(data), which sends a command including its terminating newline and returns the number of bytes sent
+	- fill(buffer, size), which reads from the analyser until the buffer holds at least size bytes
+	- fillUntil(buffer, delimiter), which reads until the buffer holds the delimiter and returns the number of bytes up to and including it.
+	  A transport which marks the end of a response may also stop there, without the delimiter
+	- readStatusByte(status), which reads the status byte without a *STB? query, or returns false if the transport cannot do so
+	Only the response bytes are added to the buffer, so a TransportRecorder records the same bytes whatever the transport.
+*/
+
+/*
+	SCPI over a raw TCP socket, by default on the telnet port of the analyser
+*/
+class RawSocketTransport {
+private:
+	boost::asio::io_service m_ioservice;
+	boost::asio::ip::tcp::socket m_socket;
+
+public:
+	static const int DEFAULT_PORT = 23;
+	static const bool STATUS_CHANNEL = false;
+
+	RawSocketTransport();
+
+	void open(const std::string &ip, int port);
+	void close();
+	bool isOpen();
+
+	std::size_t send(const std::string &data);
+	void fill(boost::asio::streambuf &buffer, std::size_t size);
+	std::size_t fillUntil(boost::asio::streambuf &buffer, char delimiter);
+	bool readStatusByte(unsigned char &status);
+};
+
+/*
+	Transport which answers the commands with an AnalyserSimulation in the same process, so that AnalyserObj can be used without an analyser
+	or a network. The responses are produced while the command is sent, reads only move them to the buffer. The IP address and port are ignored
+*/
+class SimulatedTransport {
+private:
+	AnalyserSimulation m_simulation;
+	std::string m_input; // Bytes of a command line which has not been completed yet
+	std::string m_output; // Responses which have not been read yet
+	bool m_open;
+
+	void moveOutput(boost::asio::streambuf &buffer);
+
+public:
+	static const int DEFAULT_PORT = 0;
+	static const bool STATUS_CHANNEL = false;
+
+	SimulatedTransport();
+
+	void open(const std::string &ip, int port);
+	void close();
+	bool isOpen();
+
+	std::size_t send(const std::string &data);
+	void fill(boost::asio::streambuf &buffer, std::size_t size);
+	std::size_t fillUntil(boost::asio::streambuf &buffer, char delimiter);
+	bool readStatusByte(unsigned char &status);
+
+	AnalyserSimulation &getSimulation();
+};
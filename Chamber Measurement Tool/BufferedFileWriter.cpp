@@ -0,0 +1,109 @@
+#include "BufferedFileWriter.h"
+#include <cstring>
+#include <iostream>
+
+/*
+	Constructor of the BufferedFileWriter. The buffer is allocated once and reused for every file written by the object
+*/
+BufferedFileWriter::BufferedFileWriter(std::size_t bufferSize) : m_file(nullptr), m_buffer(bufferSize), m_used(0), m_failed(false) {
+}
+
+/*
+	Opens a file for writing. An existing file is overwritten. Any file which is still open is closed first
+*/
+bool BufferedFileWriter::open(const std::string &path) {
+	close();
+
+	m_path = path;
+	m_used = 0;
+	m_failed = false;
+
+	m_file = std::fopen(path.c_str(), "wb");
+
+	if (!m_file) {
+		std::cerr << "Unable to open " << path << " for writing" << std::endl;
+		return false;
+	}
+
+	// The file is buffered by this object, so the buffering of the C library is not needed
+	std::setvbuf(m_file, nullptr, _IONBF, 0);
+
+	return true;
+}
+
+/*
+	Writes the contents of the buffer to the file. Returns false if any write to the file has failed since it was opened
+*/
+bool BufferedFileWriter::flush() {
+	if (m_file && m_used > 0) {
+		if (std::fwrite(m_buffer.data(), 1, m_used, m_file) != m_used) {
+			std::cerr << "An error occurred whilst writing to " << m_path << std::endl;
+			m_failed = true;
+		}
+	}
+
+	m_used = 0;
+
+	return !m_failed;
+}
+
+/*
+	Flushes the buffer and closes the file. Returns false if any write to the file failed
+*/
+bool BufferedFileWriter::close() {
+	if (!m_file) {
+		return true;
+	}
+
+	flush();
+
+	if (std::fclose(m_file) != 0) {
+		m_failed = true;
+	}
+
+	m_file = nullptr;
+
+	return !m_failed;
+}
+
+/*
+	Returns a pointer to a part of the buffer with room for at least the requested number of characters.
+	The buffer is flushed to the file first if there isn't enough room left.
+*/
+char *BufferedFileWriter::reserve(std::size_t characters) {
+	if (m_used + characters > m_buffer.size()) {
+		flush();
+
+		if (characters > m_buffer.size()) {
+			m_buffer.resize(characters);
+		}
+	}
+
+	return m_buffer.data() + m_used;
+}
+
+/*
+	Marks the characters up to the end pointer as used. The pointer must point into the space returned by the last call to reserve()
+*/
+void BufferedFileWriter::commit(char *end) {
+	m_used = end - m_buffer.data();
+}
+
+void BufferedFileWriter::write(const char *data, std::size_t length) {
+	char *out = reserve(length);
+	std::memcpy(out, data, length);
+	commit(out + length);
+}
+
+void BufferedFileWriter::write(const std::string &text) {
+	write(text.data(), text.length());
+}
+
+bool BufferedFileWriter::isOpen() {
+	return m_file != nullptr;
+}
+
+// Destructor of the BufferedFileWriter. Makes sure that all the data has been written to the file
+BufferedFileWriter::~BufferedFileWriter() {
+	close();
+}
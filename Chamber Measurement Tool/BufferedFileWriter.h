@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+	Simple file writer which collects the output in a large buffer and only writes to the disk once the buffer is full.
+	Writing large blocks at a time is a lot faster than writing each value separately, as is done with iostreams.
+	The writer is used as follows:
+	- reserve() returns a pointer to a part of the buffer with room for at least the requested number of characters
+	- the characters are written directly to the buffer, e.g. with formatScientific
+	- commit() is called with a pointer to the end of the written characters
+*/
+class BufferedFileWriter {
+private:
+	std::FILE *m_file; // Handle of the file which is being written
+	std::string m_path; // Path of the file which is being written, used for error messages
+
+	std::vector<char> m_buffer; // Buffer in which the output is collected
+	std::size_t m_used; // Number of characters in the buffer which have not been written to the file yet
+	bool m_failed; // Set when a write to the file failed
+
+public:
+	BufferedFileWriter(std::size_t bufferSize = 1 << 20);
+
+	bool open(const std::string &path);
+	bool close();
+	bool flush();
+
+	char *reserve(std::size_t characters);
+	void commit(char *end);
+	void write(const char *data, std::size_t length);
+	void write(const std::string &text);
+
+	bool isOpen();
+
+	~BufferedFileWriter();
+};
@@ -0,0 +1,235 @@
+#include "CampaignSimulator.h"
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cmath>
+
+CampaignPlan::CampaignPlan() {
+	name = "plan";
+	startAngle = 0;
+	stopAngle = 360;
+	stepAngle = 5;
+	cuts = 1;
+	parameters = { S21 };
+
+	samplePoints = 1601;
+	IFBW = 5e3;
+	dataTransferFormat = REAL32;
+
+	pipelined = false;
+}
+
+CampaignSimulator::CampaignSimulator(const LatencyProfile &profile) {
+	m_profile = profile;
+	m_events = nullptr;
+}
+
+/*
+	Method which adds an event to the timeline. The event starts when both the event it depends on and the instrument which carries it out
+	have finished. Returns the index of the event.
+*/
+int CampaignSimulator::schedule(CampaignActivity activity, CampaignResource resource, int cut, int position, AnalyserParameter parameter, double duration, int dependency) {
+	CampaignEvent event;
+	event.activity = activity;
+	event.resource = resource;
+	event.cut = cut;
+	event.position = position;
+	event.parameter = parameter;
+	event.duration = duration;
+	event.start = m_resourceFree[resource];
+	event.predecessor = m_resourceLast[resource];
+
+	if (dependency >= 0 && (*m_events)[dependency].end() >= event.start) {
+		event.start = (*m_events)[dependency].end();
+		event.predecessor = dependency;
+	}
+
+	m_events->push_back(event);
+
+	int index = static_cast<int>(m_events->size()) - 1;
+	m_resourceFree[resource] = event.end();
+	m_resourceLast[resource] = index;
+
+	return index;
+}
+
+/*
+	Method which predicts the timeline of a campaign. The rotator is assumed to be at the start angle when the campaign starts.
+	At every position the parameters are captured in the same way as MeasurementSystem::measureCut does it without a switch matrix: the trigger
+	source and single trigger commands, a single sweep which measures every parameter, the *OPC? query and a query which transfers the data of
+	each parameter.
+	Without pipelining the rotator only moves once the last trace at a position has been transferred, as in MeasurementSystem::measureCut.
+	With pipelining it moves as soon as the analyser reports that the last sweep has finished, so the move overlaps the data transfer.
+*/
+CampaignTimeline CampaignSimulator::simulate(const CampaignPlan &plan) {
+	CampaignTimeline timeline;
+	timeline.plan = plan;
+	timeline.totalTime = 0;
+	timeline.traces = 0;
+
+	for (int i = 0; i < ACTIVITY_COUNT; i++) {
+		timeline.criticalTime[i] = 0;
+		timeline.busyTime[i] = 0;
+	}
+
+	m_events = &timeline.events;
+	m_resourceFree[ANALYSER_RESOURCE] = m_resourceFree[ROTATOR_RESOURCE] = 0;
+	m_resourceLast[ANALYSER_RESOURCE] = m_resourceLast[ROTATOR_RESOURCE] = -1;
+
+	double stepAngle = std::max(std::abs(plan.stepAngle), 0.01);
+	int positions = static_cast<int>(std::floor(std::abs(plan.stopAngle - plan.startAngle) / stepAngle + 1e-9)) + 1;
+	double direction = (plan.stopAngle < plan.startAngle) ? -1.0 : 1.0;
+
+	double rotatorPosition = plan.startAngle;
+	int lastSweepDone = -1; // The *OPC? query which reported the end of the last sweep
+	int lastTransfer = -1; // The transfer of the last trace
+
+	for (int cut = 0; cut < plan.cuts; cut++) {
+		for (int position = 0; position < positions; position++) {
+			double angle = plan.startAngle + direction * position * stepAngle;
+			int dependency = plan.pipelined ? lastSweepDone : lastTransfer;
+
+			double moveTime = m_profile.getMoveTime(angle - rotatorPosition);
+			rotatorPosition = angle;
+
+			if (moveTime > 0) {
+				dependency = schedule(MOVE_ACTIVITY, ROTATOR_RESOURCE, cut, position, plan.parameters.empty() ? S21 : plan.parameters.front(), moveTime, dependency);
+			}
+
+			if (plan.parameters.empty()) {
+				continue;
+			}
+
+			// A single sweep measures all the parameters, which are then transferred one after the other
+			int commands = schedule(COMMAND_ACTIVITY, ANALYSER_RESOURCE, cut, position, plan.parameters.front(), 2 * m_profile.commandLatency, dependency);
+			int sweep = schedule(SWEEP_ACTIVITY, ANALYSER_RESOURCE, cut, position, plan.parameters.front(), m_profile.getSweepTime(plan.samplePoints, plan.IFBW), commands);
+			lastSweepDone = schedule(COMMAND_ACTIVITY, ANALYSER_RESOURCE, cut, position, plan.parameters.front(), m_profile.queryLatency, sweep);
+			lastTransfer = lastSweepDone;
+
+			for (AnalyserParameter parameter : plan.parameters) {
+				lastTransfer = schedule(TRANSFER_ACTIVITY, ANALYSER_RESOURCE, cut, position, parameter,
+					m_profile.queryLatency + m_profile.getTransferTime(plan.samplePoints, plan.dataTransferFormat), lastTransfer);
+
+				timeline.traces++;
+			}
+		}
+	}
+
+	m_events = nullptr;
+
+	// Follow the predecessors back from the event which finishes last
+	int last = -1;
+
+	for (std::size_t i = 0; i < timeline.events.size(); i++) {
+		timeline.busyTime[timeline.events[i].activity] += timeline.events[i].duration;
+
+		if (last < 0 || timeline.events[i].end() > timeline.events[last].end()) {
+			last = static_cast<int>(i);
+		}
+	}
+
+	if (last >= 0) {
+		timeline.totalTime = timeline.events[last].end();
+	}
+
+	for (int i = last; i >= 0; i = timeline.events[i].predecessor) {
+		timeline.criticalPath.push_back(i);
+		timeline.criticalTime[timeline.events[i].activity] += timeline.events[i].duration;
+	}
+
+	std::reverse(timeline.criticalPath.begin(), timeline.criticalPath.end());
+
+	return timeline;
+}
+
+/*
+	Method which simulates a number of plans and writes a table comparing them to the stream
+*/
+std::vector<CampaignTimeline> CampaignSimulator::compare(const std::vector<CampaignPlan> &plans, std::ostream &stream) {
+	std::vector<CampaignTimeline> timelines;
+
+	stream << boost::format("%-20s %7s %6s %9s %5s %12s %9s %9s %9s %9s %11s\n")
+		% "Plan" % "Step" % "Points" % "IFBW" % "Pipe" % "Total (s)" % "Command" % "Sweep" % "Transfer" % "Move" % "s/trace";
+
+	for (const CampaignPlan &plan : plans) {
+		timelines.push_back(simulate(plan));
+		const CampaignTimeline &timeline = timelines.back();
+
+		stream << boost::format("%-20s %7.2f %6d %9.0f %5s %12.1f %9.1f %9.1f %9.1f %9.1f %11.4f\n")
+			% plan.name % plan.stepAngle % plan.samplePoints % plan.IFBW % (plan.pipelined ? "yes" : "no") % timeline.totalTime
+			% timeline.criticalTime[COMMAND_ACTIVITY] % timeline.criticalTime[SWEEP_ACTIVITY] % timeline.criticalTime[TRANSFER_ACTIVITY]
+			% timeline.criticalTime[MOVE_ACTIVITY] % (timeline.traces > 0 ? timeline.totalTime / timeline.traces : 0.0);
+	}
+
+	return timelines;
+}
+
+/*
+	Method which writes the total time of the campaign and the breakdown of the critical path to the stream
+*/
+void CampaignTimeline::printSummary(std::ostream &stream) const {
+	int seconds = static_cast<int>(std::ceil(totalTime));
+
+	stream << "Plan: " << plan.name << std::endl;
+	stream << boost::format("Traces: %d (%d cuts, %d parameters)\n") % traces % plan.cuts % plan.parameters.size();
+	stream << boost::format("Total time: %02d:%02d:%02d (%.1f s)\n") % (seconds / 3600) % (seconds / 60 % 60) % (seconds % 60) % totalTime;
+	stream << "Critical path:" << std::endl;
+
+	for (int i = 0; i < ACTIVITY_COUNT; i++) {
+		CampaignActivity activity = static_cast<CampaignActivity>(i);
+
+		stream << boost::format("  %-10s %10.1f s %6.1f %%   (busy %.1f s)\n") % CampaignSimulator::activityName(activity) % criticalTime[i]
+			% (totalTime > 0 ? 100 * criticalTime[i] / totalTime : 0.0) % busyTime[i];
+	}
+}
+
+/*
+	Method which writes every event of the timeline to the stream as CSV, marking the events which are on the critical path
+*/
+void CampaignTimeline::writeCSV(std::ostream &stream) const {
+	std::vector<bool> critical(events.size(), false);
+
+	for (int index : criticalPath) {
+		critical[index] = true;
+	}
+
+	stream << "cut,position,activity,resource,parameter,start,duration,critical\n";
+
+	for (std::size_t i = 0; i < events.size(); i++) {
+		const CampaignEvent &event = events[i];
+
+		stream << boost::format("%d,%d,%s,%s,%s,%.6f,%.6f,%d\n") % event.cut % event.position % CampaignSimulator::activityName(event.activity)
+			% (event.resource == ANALYSER_RESOURCE ? "analyser" : "rotator") % AnalyserParameterToStringMap.at(event.parameter)
+			% event.start % event.duration % (critical[i] ? 1 : 0);
+	}
+}
+
+/*
+	Setter methods
+*/
+
+void CampaignSimulator::setProfile(const LatencyProfile &profile) {
+	m_profile = profile;
+}
+
+/*
+	Getter methods
+*/
+
+const LatencyProfile &CampaignSimulator::getProfile() const {
+	return m_profile;
+}
+
+const char *CampaignSimulator::activityName(CampaignActivity activity) {
+	switch (activity) {
+	case COMMAND_ACTIVITY:
+		return "command";
+	case SWEEP_ACTIVITY:
+		return "sweep";
+	case TRANSFER_ACTIVITY:
+		return "transfer";
+	case MOVE_ACTIVITY:
+		return "move";
+	default:
+		return "unknown";
+	}
+}
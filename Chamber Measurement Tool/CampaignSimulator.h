@@ -0,0 +1,107 @@
+#pragma once
+#include "AnalyserObj.h"
+#include "LatencyProfile.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+	Settings of a measurement campaign, i.e. one or more cuts measured with MeasurementSystem::measureCut using the same settings
+*/
+struct CampaignPlan {
+	std::string name; // Name used to identify the plan in reports
+	double startAngle; // First angle of every cut
+	double stopAngle; // Last angle of every cut
+	double stepAngle; // Angle between the positions of a cut
+	int cuts; // Number of cuts in the campaign. The rotator returns to the start angle between cuts
+	std::vector<AnalyserParameter> parameters; // Parameters captured at every position
+
+	int samplePoints; // Sample points of every sweep
+	double IFBW; // IFBW of the analyser
+	AnalyserDataTransferFormat dataTransferFormat; // Format used to transfer the data
+
+	bool pipelined; // Whether the rotator starts moving to the next position as soon as the last sweep has finished, overlapping the data transfer
+
+	CampaignPlan();
+};
+
+/*
+	The kinds of activity which make up a measurement
+*/
+enum CampaignActivity {
+	COMMAND_ACTIVITY, // Commands and short queries sent to the analyser
+	SWEEP_ACTIVITY, // Sweeps of the analyser
+	TRANSFER_ACTIVITY, // Transfer of the data to the computer
+	MOVE_ACTIVITY, // Moves of the rotator
+	ACTIVITY_COUNT
+};
+
+/*
+	The instruments which carry out the activities. An instrument can only do one thing at a time
+*/
+enum CampaignResource {
+	ANALYSER_RESOURCE,
+	ROTATOR_RESOURCE
+};
+
+/*
+	A single step in the predicted timeline of a campaign
+*/
+struct CampaignEvent {
+	CampaignActivity activity;
+	CampaignResource resource;
+	int cut; // Index of the cut
+	int position; // Index of the position within the cut
+	AnalyserParameter parameter; // The parameter being captured, for analyser events
+	double start; // Time at which the event starts, in seconds from the start of the campaign
+	double duration; // Duration of the event in seconds
+	int predecessor; // Index of the event which determined the start time of this event, -1 if it starts straight away
+
+	double end() const {
+		return start + duration;
+	}
+};
+
+/*
+	The predicted timeline of a campaign. The critical path is the chain of events which determines the total time: making any event on it
+	faster shortens the campaign, making events off it faster does not.
+*/
+struct CampaignTimeline {
+	CampaignPlan plan; // The plan which was simulated
+	std::vector<CampaignEvent> events; // All the events, in the order in which they were scheduled
+	std::vector<int> criticalPath; // Indices of the events on the critical path, from the first to the last
+	double totalTime; // Time taken by the whole campaign in seconds
+	double criticalTime[ACTIVITY_COUNT]; // Time spent on the critical path in each kind of activity
+	double busyTime[ACTIVITY_COUNT]; // Total time spent in each kind of activity, whether on the critical path or not
+	int traces; // Number of traces captured
+
+	void printSummary(std::ostream &stream) const;
+	void writeCSV(std::ostream &stream) const;
+};
+
+/*
+	Dry run of measurement campaigns. The simulator steps through the same sequence of commands, sweeps, data transfers and moves as
+	MeasurementSystem::measureCut, and takes the duration of each step from a LatencyProfile instead of the instruments. This predicts how long a
+	campaign will take and which steps limit it, so that step angle, IFBW, point count and pipelining can be traded off before booking the chamber.
+*/
+class CampaignSimulator {
+private:
+	LatencyProfile m_profile; // Timing model of the instruments
+
+	std::vector<CampaignEvent> *m_events; // The events of the timeline being simulated
+	double m_resourceFree[2]; // Time at which each instrument finishes its last event
+	int m_resourceLast[2]; // Index of the last event of each instrument, -1 if there is none yet
+
+	int schedule(CampaignActivity activity, CampaignResource resource, int cut, int position, AnalyserParameter parameter, double duration, int dependency);
+
+public:
+	CampaignSimulator(const LatencyProfile &profile = LatencyProfile());
+
+	CampaignTimeline simulate(const CampaignPlan &plan);
+	std::vector<CampaignTimeline> compare(const std::vector<CampaignPlan> &plans, std::ostream &stream);
+
+	void setProfile(const LatencyProfile &profile);
+	const LatencyProfile &getProfile() const;
+
+	static const char *activityName(CampaignActivity activity);
+};
@@ -0,0 +1,337 @@
+#include "ChamberMeasurementAPI.h"
+#include "MeasurementSystem.h"
+#include "SerialRotatorException.h"
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+/*
+	The handles given to the users of the C interface. They wrap the C++ objects together with any data which has been lent to the user
+*/
+struct cmt_analyser {
+	AnalyserObj<double> *analyser;
+	std::vector<double> lastCapture; // Data of the last capture, lent to the user through cmt_analyser_capture
+};
+
+struct cmt_rotator {
+	SerialRotatorObj *rotator;
+};
+
+struct cmt_system {
+	MeasurementSystem *system;
+};
+
+// The message describing the last error which occurred on each thread
+static thread_local std::string lastError;
+
+/*
+	Runs a function, converting any exception it throws into an error code, since exceptions may not cross the C interface
+*/
+template<class F> static int guard(F function) {
+	try {
+		function();
+		return CMT_OK;
+	}
+	catch (boost::system::system_error &e) {
+		lastError = e.what();
+	}
+	catch (SerialRotatorException &e) {
+		lastError = e.what();
+	}
+	catch (std::exception &e) {
+		lastError = e.what();
+	}
+	catch (...) {
+		lastError = "An unknown error occurred";
+	}
+
+	return CMT_ERROR;
+}
+
+/*
+	Fills in a buffer describing a trace of interleaved real and imaginary values, with the shape [samplePoints][2]
+*/
+static void describeTrace(const std::vector<double> &data, cmt_buffer *buffer) {
+	buffer->data = data.data();
+	buffer->dtype = CMT_FLOAT64;
+	buffer->itemsize = sizeof(double);
+	buffer->ndim = 2;
+	buffer->shape[0] = data.size() / 2;
+	buffer->shape[1] = 2;
+	buffer->strides[0] = 2 * sizeof(double);
+	buffer->strides[1] = sizeof(double);
+
+	for (int i = 2; i < CMT_MAXDIMENSIONS; i++) {
+		buffer->shape[i] = 0;
+		buffer->strides[i] = 0;
+	}
+}
+
+/*
+	Fills in a buffer describing a trace of a measurement cube in place, with the shape [2][samplePoints]. The first row is the row of the trace in
+	the real plane, the second row the one in the imaginary plane, so the stride between them is the distance between the two planes
+*/
+static void describeCubeTrace(const MeasurementCube<double> &cube, int angle, int trace, cmt_buffer *buffer) {
+	buffer->data = cube.real(angle, trace);
+	buffer->dtype = CMT_FLOAT64;
+	buffer->itemsize = sizeof(double);
+	buffer->ndim = 2;
+	buffer->shape[0] = 2;
+	buffer->shape[1] = cube.getSamplePoints();
+	buffer->strides[0] = (cube.imag(angle, trace) - cube.real(angle, trace)) * static_cast<int64_t>(sizeof(double));
+	buffer->strides[1] = sizeof(double);
+
+	for (int i = 2; i < CMT_MAXDIMENSIONS; i++) {
+		buffer->shape[i] = 0;
+		buffer->strides[i] = 0;
+	}
+}
+
+/*
+	Fills in a buffer describing a plane of a measurement cube, with the shape [angles][traces][samplePoints]
+*/
+static void describeCubePlane(const MeasurementCube<double> &cube, MeasurementCube<double>::Plane plane, cmt_buffer *buffer) {
+	buffer->data = cube.getPlane(plane);
+	buffer->dtype = CMT_FLOAT64;
+	buffer->itemsize = sizeof(double);
+	buffer->ndim = 3;
+	buffer->shape[0] = cube.getAngleCount();
+	buffer->shape[1] = cube.getTraceCount();
+	buffer->shape[2] = cube.getSamplePoints();
+	buffer->strides[0] = cube.getAngleStride() * sizeof(double);
+	buffer->strides[1] = cube.getRowStride() * sizeof(double);
+	buffer->strides[2] = sizeof(double);
+
+	for (int i = 3; i < CMT_MAXDIMENSIONS; i++) {
+		buffer->shape[i] = 0;
+		buffer->strides[i] = 0;
+	}
+}
+
+/*
+	Checks the result of a setter of the analyser
+*/
+static void checkResult(bool result, const char *message) {
+	if (!result) {
+		throw std::runtime_error(message);
+	}
+}
+
+int32_t cmt_api_version(void) {
+	return CMT_API_VERSION;
+}
+
+const char *cmt_last_error(void) {
+	return lastError.c_str();
+}
+
+/*
+	Analyser functions
+*/
+
+cmt_analyser *cmt_analyser_create(double startFreq, double stopFreq, double powerLvl, double IFBW, int32_t samplePoints, int32_t format, int32_t parameter, int32_t dataTransferFormat, const char *ip, int32_t port) {
+	cmt_analyser *handle = nullptr;
+
+	guard([&]() {
+		handle = new cmt_analyser;
+		handle->analyser = nullptr;
+		handle->analyser = new AnalyserObj<double>(startFreq, stopFreq, powerLvl, IFBW, samplePoints, static_cast<AnalyserFormat>(format), static_cast<AnalyserParameter>(parameter), static_cast<AnalyserDataTransferFormat>(dataTransferFormat), ip ? ip : "192.168.20.200", port);
+	});
+
+	if (handle && !handle->analyser) {
+		delete handle;
+		handle = nullptr;
+	}
+
+	return handle;
+}
+
+void cmt_analyser_destroy(cmt_analyser *analyser) {
+	if (analyser) {
+		delete analyser->analyser;
+		delete analyser;
+	}
+}
+
+int cmt_analyser_set_frequency_range(cmt_analyser *analyser, double startFreq, double stopFreq) {
+	return guard([&]() { checkResult(analyser->analyser->setFrequencyRange(startFreq, stopFreq), "Unable to set the frequency range"); });
+}
+
+int cmt_analyser_set_power_lvl(cmt_analyser *analyser, double powerLvl) {
+	return guard([&]() { checkResult(analyser->analyser->setPowerLvl(powerLvl), "Unable to set the power level"); });
+}
+
+int cmt_analyser_set_ifbw(cmt_analyser *analyser, double IFBW) {
+	return guard([&]() { checkResult(analyser->analyser->setIFBW(IFBW), "Unable to set the IFBW"); });
+}
+
+int cmt_analyser_set_sample_points(cmt_analyser *analyser, int32_t samplePoints) {
+	return guard([&]() { checkResult(analyser->analyser->setSamplePoints(samplePoints), "Unable to set the number of sample points"); });
+}
+
+int cmt_analyser_set_format(cmt_analyser *analyser, int32_t format) {
+	return guard([&]() { checkResult(analyser->analyser->setFormat(static_cast<AnalyserFormat>(format)), "Unable to set the format"); });
+}
+
+int cmt_analyser_set_parameter(cmt_analyser *analyser, int32_t parameter) {
+	return guard([&]() { checkResult(analyser->analyser->setParameter(static_cast<AnalyserParameter>(parameter)), "Unable to set the parameter"); });
+}
+
+/*
+	Captures a trace. The data is kept by the handle and lent to the user until the next capture or until the analyser is destroyed
+*/
+int cmt_analyser_capture(cmt_analyser *analyser, int32_t channel, int32_t trace, cmt_buffer *data) {
+	return guard([&]() {
+		analyser->lastCapture = analyser->analyser->captureData(channel, trace);
+		checkResult(!analyser->lastCapture.empty(), "Unable to capture data from the analyser");
+
+		describeTrace(analyser->lastCapture, data);
+	});
+}
+
+/*
+	Rotator functions
+*/
+
+cmt_rotator *cmt_rotator_create(uint8_t speed, uint8_t accel, double stepAngle, uint8_t COMPort, int32_t baudrate) {
+	cmt_rotator *handle = nullptr;
+
+	guard([&]() {
+		handle = new cmt_rotator;
+		handle->rotator = nullptr;
+		handle->rotator = new SerialRotatorObj(speed, accel, stepAngle, COMPort, baudrate);
+	});
+
+	if (handle && !handle->rotator) {
+		delete handle;
+		handle = nullptr;
+	}
+
+	return handle;
+}
+
+void cmt_rotator_destroy(cmt_rotator *rotator) {
+	if (rotator) {
+		delete rotator->rotator;
+		delete rotator;
+	}
+}
+
+int cmt_rotator_rotate_to(cmt_rotator *rotator, double position) {
+	return guard([&]() { rotator->rotator->rotateTo(position); });
+}
+
+double cmt_rotator_get_position(cmt_rotator *rotator) {
+	return rotator->rotator->getCurrentPosition();
+}
+
+/*
+	Measurement system functions
+*/
+
+cmt_system *cmt_system_create(cmt_analyser *analyser, cmt_rotator *rotator) {
+	// The measurement system takes ownership of the objects, so the handles are released whatever happens
+	AnalyserObj<double> *analyserObj = analyser ? analyser->analyser : nullptr;
+	SerialRotatorObj *rotatorObj = rotator ? rotator->rotator : nullptr;
+
+	delete analyser;
+	delete rotator;
+
+	MeasurementSystem *system = nullptr;
+	cmt_system *handle = nullptr;
+
+	guard([&]() {
+		system = new MeasurementSystem(analyserObj, rotatorObj);
+	});
+
+	// Without a measurement system nobody owns the objects
+	if (!system) {
+		delete analyserObj;
+		delete rotatorObj;
+
+		return nullptr;
+	}
+
+	guard([&]() {
+		handle = new cmt_system;
+		handle->system = system;
+	});
+
+	if (!handle) {
+		delete system;
+	}
+
+	return handle;
+}
+
+void cmt_system_destroy(cmt_system *system) {
+	if (system) {
+		delete system->system;
+		delete system;
+	}
+}
+
+int cmt_system_measure_cut(cmt_system *system, double startAngle, double stopAngle, const int32_t *parameters, int32_t parameterCount) {
+	return guard([&]() {
+		std::vector<AnalyserParameter> parameterList;
+
+		for (int32_t i = 0; i < parameterCount; i++) {
+			parameterList.push_back(static_cast<AnalyserParameter>(parameters[i]));
+		}
+
+		if (parameterList.empty()) {
+			parameterList.push_back(S21);
+		}
+
+		checkResult(system->system->measureCut(startAngle, stopAngle, parameterList), "The measurement could not be completed");
+	});
+}
+
+int32_t cmt_system_trace_count(cmt_system *system) {
+	return static_cast<int32_t>(system->system->getCapturedTraceCount());
+}
+
+/*
+	Returns the settings and the data of a trace of the last measurement. The data is lent to the user until the next measurement
+*/
+int cmt_system_trace(cmt_system *system, int32_t index, cmt_trace_info *info, cmt_buffer *data) {
+	return guard([&]() {
+		if (index < 0 || index >= system->system->getCapturedTraceCount()) {
+			throw std::out_of_range("There is no trace with the index " + std::to_string(index));
+		}
+
+		const MeasurementCube<double> &cube = system->system->getCube();
+		const int angle = index / cube.getTraceCount();
+		const int trace = index % cube.getTraceCount();
+
+		if (info) {
+			info->angle = cube.getAngle(angle);
+			info->startFreq = cube.getStartFreq();
+			info->stopFreq = cube.getStopFreq();
+			info->parameter = cube.getParameter(trace);
+			info->format = cube.getFormat();
+			info->samplePoints = cube.getSamplePoints();
+		}
+
+		if (data) {
+			describeCubeTrace(cube, angle, trace, data);
+		}
+	});
+}
+
+/*
+	Returns the real and imaginary planes of the data of the last measurement. The data is lent to the user until the next measurement
+*/
+int cmt_system_cube(cmt_system *system, cmt_buffer *real, cmt_buffer *imag) {
+	return guard([&]() {
+		const MeasurementCube<double> &cube = system->system->getCube();
+
+		if (real) {
+			describeCubePlane(cube, MeasurementCube<double>::REAL_PLANE, real);
+		}
+
+		if (imag) {
+			describeCubePlane(cube, MeasurementCube<double>::IMAG_PLANE, imag);
+		}
+	});
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+/*
+	C interface to the measurement tool, used by external analysis tools such as Python (ctypes), Octave or MATLAB.
+	The interface only uses C types and opaque handles so that it stays stable between compilers and versions of the tool.
+	
+	Captured data is not copied out of the library. Instead, functions which return data fill in a cmt_buffer, which describes memory owned by the
+	library with its shape and strides (in bytes), in the same way as the Python buffer protocol or NumPy's __array_interface__.
+	The memory is borrowed: it remains valid until the handle which owns it captures new data or is destroyed.
+	
+	Functions which return an int return CMT_OK on success and CMT_ERROR on failure. Functions which return a handle return NULL on failure.
+	The reason for the last failure on the calling thread can be retrieved with cmt_last_error().
+*/
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(CMT_BUILD_DLL)
+#define CMT_API __declspec(dllexport)
+#else
+#define CMT_API __declspec(dllimport)
+#endif
+#else
+#define CMT_API __attribute__((visibility("default")))
+#endif
+
+#define CMT_API_VERSION 1
+
+#define CMT_OK 0
+#define CMT_ERROR -1
+
+#define CMT_MAXDIMENSIONS 4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Data types of the elements of a buffer
+*/
+enum cmt_dtype {
+	CMT_FLOAT64 = 0,
+	CMT_FLOAT32 = 1
+};
+
+/*
+	Description of a block of memory owned by the library.
+	Element [i0][i1]... is found at (const char *)data + i0 * strides[0] + i1 * strides[1] + ...
+*/
+typedef struct cmt_buffer {
+	const void *data; // Address of the first element
+	int32_t dtype; // One of cmt_dtype
+	int32_t itemsize; // Size of a single element in bytes
+	int32_t ndim; // Number of dimensions in use
+	int64_t shape[CMT_MAXDIMENSIONS]; // Number of elements along each dimension
+	int64_t strides[CMT_MAXDIMENSIONS]; // Distance in bytes between consecutive elements along each dimension
+} cmt_buffer;
+
+/*
+	Settings which were in use when a trace was captured
+*/
+typedef struct cmt_trace_info {
+	double angle;
+	double startFreq;
+	double stopFreq;
+	int32_t parameter; // Value of AnalyserParameter, i.e. 0 = S11, 1 = S12, 2 = S21, 3 = S22, 4 = S31
+	int32_t format; // Value of AnalyserFormat, i.e. 0 = MLOG, 1 = PHAS, 2 = VSWR, 3 = SMIT
+	int32_t samplePoints;
+} cmt_trace_info;
+
+typedef struct cmt_analyser cmt_analyser;
+typedef struct cmt_rotator cmt_rotator;
+typedef struct cmt_system cmt_system;
+
+CMT_API int32_t cmt_api_version(void);
+CMT_API const char *cmt_last_error(void);
+
+/*
+	Analyser functions. The captured data has the shape [samplePoints][2], i.e. a row of real and imaginary values for every sample point
+*/
+CMT_API cmt_analyser *cmt_analyser_create(double startFreq, double stopFreq, double powerLvl, double IFBW, int32_t samplePoints, int32_t format, int32_t parameter, int32_t dataTransferFormat, const char *ip, int32_t port);
+CMT_API void cmt_analyser_destroy(cmt_analyser *analyser);
+CMT_API int cmt_analyser_set_frequency_range(cmt_analyser *analyser, double startFreq, double stopFreq);
+CMT_API int cmt_analyser_set_power_lvl(cmt_analyser *analyser, double powerLvl);
+CMT_API int cmt_analyser_set_ifbw(cmt_analyser *analyser, double IFBW);
+CMT_API int cmt_analyser_set_sample_points(cmt_analyser *analyser, int32_t samplePoints);
+CMT_API int cmt_analyser_set_format(cmt_analyser *analyser, int32_t format);
+CMT_API int cmt_analyser_set_parameter(cmt_analyser *analyser, int32_t parameter);
+CMT_API int cmt_analyser_capture(cmt_analyser *analyser, int32_t channel, int32_t trace, cmt_buffer *data);
+
+/*
+	Rotator functions
+*/
+CMT_API cmt_rotator *cmt_rotator_create(uint8_t speed, uint8_t accel, double stepAngle, uint8_t COMPort, int32_t baudrate);
+CMT_API void cmt_rotator_destroy(cmt_rotator *rotator);
+CMT_API int cmt_rotator_rotate_to(cmt_rotator *rotator, double position);
+CMT_API double cmt_rotator_get_position(cmt_rotator *rotator);
+
+/*
+	Measurement system functions. cmt_system_create takes ownership of the analyser and the rotator: their handles are released by the call
+	and must not be used or destroyed afterwards, even if the call fails.
+	The traces of the last measurement remain valid until the next measurement or until the system is destroyed.
+	cmt_system_trace describes a single trace in place with the shape [2][samplePoints], i.e. a row of real values followed by a row of imaginary
+	values. The rows are taken from the two planes of the measurement cube, so the trace is not copied.
+	cmt_system_cube describes all the data of the last measurement at once as two planes, holding the real and the imaginary values, with the
+	shape [angles][traces][samplePoints]. The sample points of a trace are contiguous, the rows are padded so that each starts on a 64 byte boundary.
+*/
+CMT_API cmt_system *cmt_system_create(cmt_analyser *analyser, cmt_rotator *rotator);
+CMT_API void cmt_system_destroy(cmt_system *system);
+CMT_API int cmt_system_measure_cut(cmt_system *system, double startAngle, double stopAngle, const int32_t *parameters, int32_t parameterCount);
+CMT_API int32_t cmt_system_trace_count(cmt_system *system);
+CMT_API int cmt_system_trace(cmt_system *system, int32_t index, cmt_trace_info *info, cmt_buffer *data);
+CMT_API int cmt_system_cube(cmt_system *system, cmt_buffer *real, cmt_buffer *imag);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,184 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+/*
+	Lightweight number formatting functions used by the exporters.
+	These work in the same way as std::to_chars: the characters are written directly to the supplied buffer and a pointer to the
+	end of the written characters is returned. No locale handling or stream state is involved, which makes them a lot faster than iostreams
+	when hundreds of thousands of values need to be written. The caller must make sure that there is enough room in the buffer,
+	FASTFORMAT_MAXLENGTH characters is always sufficient for a single value.
+*/
+const int FASTFORMAT_MAXLENGTH = 32;
+const int FASTFORMAT_MAXPRECISION = 17;
+
+namespace FastFormat {
+	/*
+		Table of the powers of 10 which can be represented exactly by a double
+	*/
+	const double POW10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	const std::uint64_t UPOW10[] = {
+		1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+		10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+		1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull
+	};
+
+	/*
+		Scales a value by 10^exponent, using an exact power of 10 where possible so that the result is correctly rounded
+	*/
+	inline double scale(double value, int exponent) {
+		if (exponent >= 0 && exponent <= 22) {
+			return value * POW10[exponent];
+		}
+		else if (exponent < 0 && exponent >= -22) {
+			return value / POW10[-exponent];
+		}
+		else {
+			// Scale in two steps so that very small values do not overflow the intermediate power of 10
+			return (value * std::pow(10.0, exponent / 2)) * std::pow(10.0, exponent - exponent / 2);
+		}
+	}
+
+	/*
+		Writes an unsigned integer, padded with leading zeros up to minDigits digits
+	*/
+	inline char *formatUnsigned(char *out, std::uint64_t value, int minDigits = 1) {
+		char digits[20];
+		int count = 0;
+
+		do {
+			digits[count++] = static_cast<char>('0' + value % 10);
+			value /= 10;
+		} while (value != 0);
+
+		while (count < minDigits) {
+			digits[count++] = '0';
+		}
+
+		while (count > 0) {
+			*out++ = digits[--count];
+		}
+
+		return out;
+	}
+
+	/*
+		Writes NaN and infinite values. Returns nullptr if the value is finite
+	*/
+	inline char *formatSpecial(char *out, double value) {
+		if (std::isnan(value)) {
+			*out++ = 'n'; *out++ = 'a'; *out++ = 'n';
+			return out;
+		}
+
+		if (std::isinf(value)) {
+			if (value < 0) {
+				*out++ = '-';
+			}
+			*out++ = 'i'; *out++ = 'n'; *out++ = 'f';
+			return out;
+		}
+
+		return nullptr;
+	}
+}
+
+/*
+	Writes a value in scientific notation with the given number of digits after the decimal point, e.g. -1.234560e+01.
+	This produces the same output as printf("%.*e") as long as no more digits are requested than a double can hold (about 15 significant digits).
+*/
+inline char *formatScientific(char *out, double value, int precision) {
+	using namespace FastFormat;
+
+	if (char *special = formatSpecial(out, value)) {
+		return special;
+	}
+
+	precision = std::min(std::max(precision, 0), FASTFORMAT_MAXPRECISION);
+
+	if (std::signbit(value)) {
+		*out++ = '-';
+		value = -value;
+	}
+
+	std::uint64_t mantissa = 0;
+	int exponent = 0;
+
+	if (value != 0.0) {
+		exponent = static_cast<int>(std::floor(std::log10(value)));
+
+		// The logarithm can be off by one for values close to a power of 10, so correct the exponent if the mantissa overflows or underflows
+		mantissa = static_cast<std::uint64_t>(std::nearbyint(scale(value, precision - exponent)));
+
+		if (mantissa >= UPOW10[precision + 1]) {
+			exponent++;
+			mantissa = static_cast<std::uint64_t>(std::nearbyint(scale(value, precision - exponent)));
+		}
+		else if (mantissa < UPOW10[precision]) {
+			exponent--;
+			mantissa = static_cast<std::uint64_t>(std::nearbyint(scale(value, precision - exponent)));
+		}
+
+		// Rounding up can still carry over into an extra digit, e.g. 9.9996 with 3 digits
+		if (mantissa >= UPOW10[precision + 1]) {
+			mantissa /= 10;
+			exponent++;
+		}
+	}
+
+	std::uint64_t leading = mantissa / UPOW10[precision];
+	*out++ = static_cast<char>('0' + leading);
+
+	if (precision > 0) {
+		*out++ = '.';
+		out = formatUnsigned(out, mantissa - leading * UPOW10[precision], precision);
+	}
+
+	*out++ = 'e';
+	*out++ = (exponent < 0) ? '-' : '+';
+	out = formatUnsigned(out, static_cast<std::uint64_t>(std::abs(exponent)), 2);
+
+	return out;
+}
+
+/*
+	Writes a value in fixed point notation with the given number of digits after the decimal point, e.g. -12.3456.
+	As with formatScientific, only the first 15 or so significant digits are exact.
+	Values which are too large to be represented as a 64 bit integer after scaling fall back on scientific notation.
+*/
+inline char *formatFixed(char *out, double value, int decimals) {
+	using namespace FastFormat;
+
+	if (char *special = formatSpecial(out, value)) {
+		return special;
+	}
+
+	decimals = std::min(std::max(decimals, 0), FASTFORMAT_MAXPRECISION);
+
+	double scaled = scale(std::fabs(value), decimals);
+
+	if (scaled >= 9.2e18) {
+		return formatScientific(out, value, decimals);
+	}
+
+	std::uint64_t rounded = static_cast<std::uint64_t>(std::nearbyint(scaled));
+
+	if (std::signbit(value)) {
+		*out++ = '-';
+	}
+
+	std::uint64_t integerPart = rounded / UPOW10[decimals];
+	out = formatUnsigned(out, integerPart);
+
+	if (decimals > 0) {
+		*out++ = '.';
+		out = formatUnsigned(out, rounded - integerPart * UPOW10[decimals], decimals);
+	}
+
+	return out;
+}
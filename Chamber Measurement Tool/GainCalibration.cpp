@@ -0,0 +1,232 @@
+#include "GainCalibration.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GAINCALIBRATION_SSE2
+#endif
+
+bool CalibrationTable::empty() const {
+	return frequencies.empty();
+}
+
+/*
+	Method which returns the value at a frequency, interpolated linearly between the two nearest frequencies of the table
+*/
+double CalibrationTable::interpolate(double frequency) const {
+	if (frequencies.empty()) {
+		return 0.0;
+	}
+
+	if (frequency <= frequencies.front()) {
+		return values.front();
+	}
+
+	if (frequency >= frequencies.back()) {
+		return values.back();
+	}
+
+	std::size_t upper = std::upper_bound(frequencies.begin(), frequencies.end(), frequency) - frequencies.begin();
+	std::size_t lower = upper - 1;
+	double fraction = (frequency - frequencies[lower]) / (frequencies[upper] - frequencies[lower]);
+
+	return values[lower] + fraction * (values[upper] - values[lower]);
+}
+
+GainCalibration::GainCalibration() {
+	m_startFreq = 0;
+	m_stopFreq = 0;
+	m_samplePoints = 0;
+	m_prepared = false;
+}
+
+/*
+	Method which reads a table from a text file with a frequency in Hz and a value in dB on every line, separated by a comma, a semicolon or
+	white space. Lines which do not start with a number are skipped, e.g. a header row or comments starting with # or !
+*/
+bool GainCalibration::loadTable(GainCalibrationTable table, const std::string &fileName) {
+	std::ifstream file(fileName);
+
+	if (!file) {
+		std::cerr << "Unable to open the calibration table " << fileName << std::endl;
+		return false;
+	}
+
+	std::vector<double> frequencies;
+	std::vector<double> values;
+	std::string line;
+
+	while (std::getline(file, line)) {
+		std::replace(line.begin(), line.end(), ',', ' ');
+		std::replace(line.begin(), line.end(), ';', ' ');
+
+		const char *begin = line.c_str();
+		char *end;
+		double frequency = std::strtod(begin, &end);
+
+		if (end == begin) {
+			continue;
+		}
+
+		begin = end;
+		double value = std::strtod(begin, &end);
+
+		if (end == begin) {
+			std::cerr << "The line \"" << line << "\" of the calibration table " << fileName << " has no value" << std::endl;
+			return false;
+		}
+
+		frequencies.push_back(frequency);
+		values.push_back(value);
+	}
+
+	if (frequencies.empty()) {
+		std::cerr << "The calibration table " << fileName << " is empty" << std::endl;
+		return false;
+	}
+
+	return setTable(table, frequencies, values);
+}
+
+/*
+	Method which interpolates the tables onto the frequency grid of the sweeps, the same grid as MeasurementCube::getFrequency(). Nothing is done
+	if the corrections were already prepared for the same grid. Warns if the grid reaches beyond a table, since the value at its end is used there.
+*/
+bool GainCalibration::prepare(double startFreq, double stopFreq, int samplePoints) {
+	if (samplePoints < 1) {
+		std::cerr << "The calibration needs at least one sample point" << std::endl;
+		return false;
+	}
+
+	if (m_prepared && startFreq == m_startFreq && stopFreq == m_stopFreq && samplePoints == m_samplePoints) {
+		return true;
+	}
+
+	for (const CalibrationTable &table : m_tables) {
+		if (!table.empty() && (std::min(startFreq, stopFreq) < table.frequencies.front() || std::max(startFreq, stopFreq) > table.frequencies.back())) {
+			std::cout << "The frequency range " << startFreq << " to " << stopFreq << " Hz is not fully covered by a calibration table, the values at its ends are extended" << std::endl;
+			break;
+		}
+	}
+
+	m_offsets.resize(samplePoints);
+	m_factors.resize(samplePoints);
+
+	for (int point = 0; point < samplePoints; point++) {
+		double frequency = (samplePoints < 2) ? startFreq : startFreq + point * (stopFreq - startFreq) / (samplePoints - 1);
+		double offset = m_tables[REFERENCE_GAIN].interpolate(frequency) - m_tables[REFERENCE_MEASUREMENT].interpolate(frequency) + m_tables[PATH_LOSS].interpolate(frequency);
+
+		m_offsets[point] = offset;
+		m_factors[point] = std::pow(10.0, offset / 20.0);
+	}
+
+	m_startFreq = startFreq;
+	m_stopFreq = stopFreq;
+	m_samplePoints = samplePoints;
+	m_prepared = true;
+
+	return true;
+}
+
+/*
+	Method which returns whether the traces of a parameter are corrected, i.e. whether it is a transmission parameter
+*/
+bool GainCalibration::appliesTo(AnalyserParameter parameter) const {
+	return parameter == S21 || parameter == S12 || parameter == S31;
+}
+
+/*
+	Method which corrects a trace in place. The trace must have the number of sample points which the calibration was prepared for, with the
+	real and imaginary values in separate arrays as in MeasurementCube. Two points are corrected per instruction where SSE2 is available.
+*/
+void GainCalibration::apply(AnalyserFormat format, double *real, double *imag) const {
+	const int samplePoints = m_samplePoints;
+	int point = 0;
+
+	if (format == MLOG) {
+		const double *offsets = m_offsets.data();
+
+#ifdef GAINCALIBRATION_SSE2
+		for (; point + 4 <= samplePoints; point += 4) {
+			_mm_storeu_pd(real + point, _mm_add_pd(_mm_loadu_pd(real + point), _mm_load_pd(offsets + point)));
+			_mm_storeu_pd(real + point + 2, _mm_add_pd(_mm_loadu_pd(real + point + 2), _mm_load_pd(offsets + point + 2)));
+		}
+#endif
+
+		for (; point < samplePoints; point++) {
+			real[point] += offsets[point];
+		}
+	}
+	else if (format == SMIT) {
+		const double *factors = m_factors.data();
+
+#ifdef GAINCALIBRATION_SSE2
+		for (; point + 4 <= samplePoints; point += 4) {
+			__m128d factor0 = _mm_load_pd(factors + point);
+			__m128d factor1 = _mm_load_pd(factors + point + 2);
+
+			_mm_storeu_pd(real + point, _mm_mul_pd(_mm_loadu_pd(real + point), factor0));
+			_mm_storeu_pd(real + point + 2, _mm_mul_pd(_mm_loadu_pd(real + point + 2), factor1));
+			_mm_storeu_pd(imag + point, _mm_mul_pd(_mm_loadu_pd(imag + point), factor0));
+			_mm_storeu_pd(imag + point + 2, _mm_mul_pd(_mm_loadu_pd(imag + point + 2), factor1));
+		}
+#endif
+
+		for (; point < samplePoints; point++) {
+			real[point] *= factors[point];
+			imag[point] *= factors[point];
+		}
+	}
+}
+
+/*
+	Method which sets a table from the frequencies in Hz and the values in dB. The frequencies are sorted if they are not in ascending order.
+	The corrections are prepared again on the next call to prepare().
+*/
+bool GainCalibration::setTable(GainCalibrationTable table, const std::vector<double> &frequencies, const std::vector<double> &values) {
+	if (frequencies.size() != values.size()) {
+		std::cerr << "A calibration table needs a value for every frequency" << std::endl;
+		return false;
+	}
+
+	std::vector<std::size_t> order(frequencies.size());
+
+	for (std::size_t i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return frequencies[a] < frequencies[b]; });
+
+	CalibrationTable &target = m_tables[table];
+	target.frequencies.resize(order.size());
+	target.values.resize(order.size());
+
+	for (std::size_t i = 0; i < order.size(); i++) {
+		target.frequencies[i] = frequencies[order[i]];
+		target.values[i] = values[order[i]];
+	}
+
+	m_prepared = false;
+
+	return true;
+}
+
+const CalibrationTable &GainCalibration::getTable(GainCalibrationTable table) const {
+	return m_tables[table];
+}
+
+int GainCalibration::getSamplePoints() const {
+	return m_samplePoints;
+}
+
+const double *GainCalibration::getOffsets() const {
+	return m_offsets.data();
+}
+
+const double *GainCalibration::getFactors() const {
+	return m_factors.data();
+}
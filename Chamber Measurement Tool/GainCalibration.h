@@ -0,0 +1,71 @@
+#pragma once
+#include "AnalyserObj.h"
+#include <boost/align/aligned_allocator.hpp>
+#include <string>
+#include <vector>
+
+/*
+	The tables which make up a gain transfer calibration, all in dB against frequency in Hz
+*/
+enum GainCalibrationTable {
+	REFERENCE_GAIN, // Gain of the reference horn in dBi, from its calibration certificate
+	REFERENCE_MEASUREMENT, // Transmission measured with the reference horn in place of the antenna under test
+	PATH_LOSS // Loss of the cables and adapters which are in the path of the antenna under test but not in that of the reference horn
+};
+
+/*
+	A correction in dB given at a number of frequencies, which is linearly interpolated in between and held constant beyond the first and last
+	frequency
+*/
+struct CalibrationTable {
+	std::vector<double> frequencies; // In ascending order
+	std::vector<double> values; // In dB
+
+	bool empty() const;
+	double interpolate(double frequency) const;
+};
+
+/*
+	Gain transfer calibration, which turns the transmission measured with the antenna under test into its absolute gain:
+		gain = measured transmission + reference horn gain - transmission measured with the reference horn + path loss
+	The tables are interpolated onto the frequency grid of the sweeps once, in prepare(), which leaves a correction per sample point both as an
+	offset in dB and as a linear factor. apply() then corrects a trace in place with SIMD instructions, so MeasurementSystem can correct every
+	trace as soon as it has been captured, before it is published.
+	Only transmission parameters (S21, S12 and S31) are corrected. The offset is added to MLOG traces and the factor scales both parts of SMIT traces;
+	PHAS and VSWR traces are not affected by the calibration.
+*/
+class GainCalibration {
+private:
+	typedef std::vector<double, boost::alignment::aligned_allocator<double, 64>> AlignedVector;
+
+	CalibrationTable m_tables[3]; // Indexed by GainCalibrationTable
+
+	double m_startFreq; // Frequency grid for which the corrections were prepared
+	double m_stopFreq;
+	int m_samplePoints;
+	bool m_prepared; // Whether the corrections match the grid and the tables
+
+	AlignedVector m_offsets; // Correction of every sample point in dB
+	AlignedVector m_factors; // Correction of every sample point as a factor on the amplitude
+
+public:
+	GainCalibration();
+
+	bool loadTable(GainCalibrationTable table, const std::string &fileName);
+	bool prepare(double startFreq, double stopFreq, int samplePoints);
+	bool appliesTo(AnalyserParameter parameter) const;
+	void apply(AnalyserFormat format, double *real, double *imag) const;
+
+	/*
+		Setter methods
+	*/
+	bool setTable(GainCalibrationTable table, const std::vector<double> &frequencies, const std::vector<double> &values);
+
+	/*
+		Getter methods
+	*/
+	const CalibrationTable &getTable(GainCalibrationTable table) const;
+	int getSamplePoints() const;
+	const double *getOffsets() const;
+	const double *getFactors() const;
+};
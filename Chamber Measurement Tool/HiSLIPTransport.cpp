@@ -0,0 +1,274 @@
+#include "HiSLIPTransport.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+HiSLIPHeader::HiSLIPHeader(unsigned char messageType, unsigned char controlCode, std::uint32_t messageParameter, std::uint64_t payloadLength)
+	: messageType(messageType), controlCode(controlCode), messageParameter(messageParameter), payloadLength(payloadLength) {
+}
+
+void HiSLIPHeader::encode(char *out) const {
+	out[0] = 'H';
+	out[1] = 'S';
+	out[2] = static_cast<char>(messageType);
+	out[3] = static_cast<char>(controlCode);
+
+	for (int i = 0; i < 4; i++) {
+		out[4 + i] = static_cast<char>(messageParameter >> (8 * (3 - i)));
+	}
+
+	for (int i = 0; i < 8; i++) {
+		out[8 + i] = static_cast<char>(payloadLength >> (8 * (7 - i)));
+	}
+}
+
+/*
+	Reads the fields of a header. Returns false if the bytes do not start with the HiSLIP prologue
+*/
+bool HiSLIPHeader::decode(const char *in) {
+	if (in[0] != 'H' || in[1] != 'S') {
+		return false;
+	}
+
+	messageType = static_cast<unsigned char>(in[2]);
+	controlCode = static_cast<unsigned char>(in[3]);
+	messageParameter = 0;
+	payloadLength = 0;
+
+	for (int i = 0; i < 4; i++) {
+		messageParameter = (messageParameter << 8) | static_cast<unsigned char>(in[4 + i]);
+	}
+
+	for (int i = 0; i < 8; i++) {
+		payloadLength = (payloadLength << 8) | static_cast<unsigned char>(in[8 + i]);
+	}
+
+	return true;
+}
+
+HiSLIPTransport::HiSLIPTransport() : m_syncSocket(m_ioservice), m_asyncSocket(m_ioservice), m_subAddress("hislip0"), m_messageID(FIRST_MESSAGE_ID), m_maximumMessageSize(1 << 20), m_responseDelivered(false) {
+}
+
+/*
+	Sends a message, the header and the payload in a single write
+*/
+void HiSLIPTransport::sendMessage(boost::asio::ip::tcp::socket &socket, const HiSLIPHeader &header, const char *payload) {
+	char encoded[HiSLIPHeader::SIZE];
+	header.encode(encoded);
+
+	std::vector<boost::asio::const_buffer> buffers;
+	buffers.push_back(boost::asio::buffer(encoded));
+
+	if (header.payloadLength > 0) {
+		buffers.push_back(boost::asio::buffer(payload, static_cast<std::size_t>(header.payloadLength)));
+	}
+
+	boost::asio::write(socket, buffers);
+}
+
+/*
+	Receives a message which is not a response to a command, i.e. during the set up of the session and on the asynchronous channel
+*/
+void HiSLIPTransport::receiveMessage(boost::asio::ip::tcp::socket &socket, HiSLIPHeader &header, std::string &payload) {
+	char encoded[HiSLIPHeader::SIZE];
+	boost::asio::read(socket, boost::asio::buffer(encoded));
+
+	if (!header.decode(encoded)) {
+		throw boost::system::system_error(boost::asio::error::invalid_argument, "The analyser did not send a HiSLIP message");
+	}
+
+	payload.resize(static_cast<std::size_t>(header.payloadLength));
+
+	if (!payload.empty()) {
+		boost::asio::read(socket, boost::asio::buffer(&payload[0], payload.size()));
+	}
+}
+
+/*
+	Receives the next message of a response on the synchronous channel and adds its payload to the buffer. The payload is read straight into
+	the buffer, since it holds the binary data blocks of the traces
+*/
+void HiSLIPTransport::receiveData(boost::asio::streambuf &buffer) {
+	while (true) {
+		char encoded[HiSLIPHeader::SIZE];
+		HiSLIPHeader header;
+		boost::asio::read(m_syncSocket, boost::asio::buffer(encoded));
+
+		if (!header.decode(encoded)) {
+			throw boost::system::system_error(boost::asio::error::invalid_argument, "The analyser did not send a HiSLIP message");
+		}
+
+		if (header.messageType == HISLIP_DATA || header.messageType == HISLIP_DATA_END) {
+			if (header.payloadLength > 0) {
+				boost::asio::read(m_syncSocket, buffer, boost::asio::transfer_exactly(static_cast<std::size_t>(header.payloadLength)));
+			}
+
+			m_responseDelivered = (header.messageType == HISLIP_DATA_END);
+			return;
+		}
+
+		std::string payload(static_cast<std::size_t>(header.payloadLength), '\0');
+
+		if (!payload.empty()) {
+			boost::asio::read(m_syncSocket, boost::asio::buffer(&payload[0], payload.size()));
+		}
+
+		if (header.messageType == HISLIP_FATAL_ERROR) {
+			throw boost::system::system_error(boost::asio::error::connection_aborted, "HiSLIP fatal error: " + payload);
+		}
+
+		if (header.messageType == HISLIP_ERROR) {
+			std::cerr << "The analyser reported a HiSLIP error: " << payload << std::endl;
+		}
+	}
+}
+
+/*
+	Opens both channels of a session with the analyser, closing the previous session if there is one
+*/
+void HiSLIPTransport::open(const std::string &ip, int port) {
+	boost::asio::ip::tcp::endpoint ep(boost::asio::ip::address::from_string(ip), port);
+	HiSLIPHeader header;
+	std::string payload;
+
+	close();
+
+	m_syncSocket.connect(ep);
+	m_syncSocket.set_option(boost::asio::ip::tcp::no_delay(true));
+
+	sendMessage(m_syncSocket, HiSLIPHeader(HISLIP_INITIALIZE, 0, (PROTOCOL_VERSION << 16) | VENDOR_ID, m_subAddress.size()), m_subAddress.data());
+	receiveMessage(m_syncSocket, header, payload);
+
+	if (header.messageType != HISLIP_INITIALIZE_RESPONSE) {
+		throw boost::system::system_error(boost::asio::error::connection_refused, "The analyser did not accept the HiSLIP session");
+	}
+
+	// The session ID is in the lower 16 bits of the parameter, it ties the asynchronous channel to the session
+	const std::uint32_t sessionID = header.messageParameter & 0xFFFF;
+
+	m_asyncSocket.connect(ep);
+	m_asyncSocket.set_option(boost::asio::ip::tcp::no_delay(true));
+
+	sendMessage(m_asyncSocket, HiSLIPHeader(HISLIP_ASYNC_INITIALIZE, 0, sessionID));
+	receiveMessage(m_asyncSocket, header, payload);
+
+	if (header.messageType != HISLIP_ASYNC_INITIALIZE_RESPONSE) {
+		throw boost::system::system_error(boost::asio::error::connection_refused, "The analyser did not accept the asynchronous HiSLIP channel");
+	}
+
+	// Exchange the largest message sizes, ours being the largest response we accept
+	char size[8];
+
+	for (int i = 0; i < 8; i++) {
+		size[i] = static_cast<char>(static_cast<std::uint64_t>(1 << 30) >> (8 * (7 - i)));
+	}
+
+	sendMessage(m_asyncSocket, HiSLIPHeader(HISLIP_ASYNC_MAXIMUM_MESSAGE_SIZE, 0, 0, sizeof(size)), size);
+	receiveMessage(m_asyncSocket, header, payload);
+
+	if (header.messageType == HISLIP_ASYNC_MAXIMUM_MESSAGE_SIZE_RESPONSE && payload.size() == 8) {
+		m_maximumMessageSize = 0;
+
+		for (char byte : payload) {
+			m_maximumMessageSize = (m_maximumMessageSize << 8) | static_cast<unsigned char>(byte);
+		}
+	}
+
+	m_messageID = FIRST_MESSAGE_ID;
+	m_responseDelivered = false;
+}
+
+void HiSLIPTransport::close() {
+	if (m_asyncSocket.is_open()) {
+		m_asyncSocket.close();
+	}
+
+	if (m_syncSocket.is_open()) {
+		m_syncSocket.close();
+	}
+}
+
+bool HiSLIPTransport::isOpen() {
+	return m_syncSocket.is_open() && m_asyncSocket.is_open();
+}
+
+/*
+	Sends a command as one message, split into Data messages ending with a DataEnd if it is larger than the analyser accepts.
+	The newline which terminates the command is kept, since the analyser accepts it and the simulations rely on it
+*/
+std::size_t HiSLIPTransport::send(const std::string &data) {
+	const std::size_t chunkSize = static_cast<std::size_t>(std::max<std::uint64_t>(m_maximumMessageSize, HiSLIPHeader::SIZE + 1) - HiSLIPHeader::SIZE);
+	std::size_t sent = 0;
+
+	do {
+		const std::size_t length = std::min(chunkSize, data.size() - sent);
+		const bool last = (sent + length == data.size());
+
+		// The first message after a complete response tells the analyser that the response was delivered
+		sendMessage(m_syncSocket, HiSLIPHeader(last ? HISLIP_DATA_END : HISLIP_DATA, m_responseDelivered ? 1 : 0, m_messageID, length), data.data() + sent);
+		m_responseDelivered = false;
+		sent += length;
+	} while (sent < data.size());
+
+	m_messageID += 2;
+
+	return sent;
+}
+
+void HiSLIPTransport::fill(boost::asio::streambuf &buffer, std::size_t size) {
+	while (buffer.size() < size) {
+		receiveData(buffer);
+	}
+}
+
+std::size_t HiSLIPTransport::fillUntil(boost::asio::streambuf &buffer, char delimiter) {
+	std::size_t searched = 0;
+
+	while (true) {
+		const char *begin = boost::asio::buffer_cast<const char *>(buffer.data());
+		const char *end = begin + buffer.size();
+		const char *found = std::find(begin + searched, end, delimiter);
+
+		if (found != end) {
+			return found - begin + 1;
+		}
+
+		// The DataEnd message ends the response, also when the analyser did not terminate it with the delimiter
+		if (m_responseDelivered && begin != end) {
+			return buffer.size();
+		}
+
+		searched = buffer.size();
+		receiveData(buffer);
+	}
+}
+
+/*
+	Reads the status byte on the asynchronous channel, so it does not wait behind the commands on the synchronous channel
+*/
+bool HiSLIPTransport::readStatusByte(unsigned char &status) {
+	HiSLIPHeader header;
+	std::string payload;
+
+	sendMessage(m_asyncSocket, HiSLIPHeader(HISLIP_ASYNC_STATUS_QUERY, m_responseDelivered ? 1 : 0, m_messageID - 2));
+	receiveMessage(m_asyncSocket, header, payload);
+
+	if (header.messageType != HISLIP_ASYNC_STATUS_RESPONSE) {
+		return false;
+	}
+
+	status = header.controlCode;
+
+	return true;
+}
+
+/*
+	Sets the name of the device within the instrument, which is used when the next session is opened
+*/
+void HiSLIPTransport::setSubAddress(const std::string &subAddress) {
+	m_subAddress = subAddress;
+}
+
+std::string HiSLIPTransport::getSubAddress() {
+	return m_subAddress;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <string>
+
+/*
+	Message types of the HiSLIP protocol (IVI-6.1) which are used by HiSLIPTransport
+*/
+enum HiSLIPMessageType {
+	HISLIP_INITIALIZE = 0,
+	HISLIP_INITIALIZE_RESPONSE = 1,
+	HISLIP_FATAL_ERROR = 2,
+	HISLIP_ERROR = 3,
+	HISLIP_DATA = 6,
+	HISLIP_DATA_END = 7,
+	HISLIP_ASYNC_MAXIMUM_MESSAGE_SIZE = 15,
+	HISLIP_ASYNC_MAXIMUM_MESSAGE_SIZE_RESPONSE = 16,
+	HISLIP_ASYNC_INITIALIZE = 17,
+	HISLIP_ASYNC_INITIALIZE_RESPONSE = 18,
+	HISLIP_ASYNC_STATUS_QUERY = 21,
+	HISLIP_ASYNC_STATUS_RESPONSE = 22
+};
+
+/*
+	Header which starts every HiSLIP message: the prologue "HS", the message type, the control code, the message parameter and the length of the
+	payload which follows, 16 bytes in all with the numbers in network byte order
+*/
+struct HiSLIPHeader {
+	static const std::size_t SIZE = 16;
+
+	unsigned char messageType;
+	unsigned char controlCode;
+	std::uint32_t messageParameter;
+	std::uint64_t payloadLength;
+
+	HiSLIPHeader(unsigned char messageType = HISLIP_DATA_END, unsigned char controlCode = 0, std::uint32_t messageParameter = 0, std::uint64_t payloadLength = 0);
+
+	void encode(char *out) const;
+	bool decode(const char *in);
+};
+
+/*
+	SCPI over HiSLIP, the protocol which replaces VXI-11 on current instruments. A HiSLIP session uses two TCP connections to the same port:
+	- the synchronous channel carries the commands and responses, framed as Data and DataEnd messages, so the end of a response is known
+	  without scanning it for a newline
+	- the asynchronous channel carries the status queries, which the analyser answers straight away, even while a command such as a sweep
+	  is still being processed on the synchronous channel
+	Only the parts of the protocol needed by AnalyserObj are implemented: no locking, no device clear and no overlapped mode.
+*/
+class HiSLIPTransport {
+private:
+	static const std::uint32_t FIRST_MESSAGE_ID = 0xFFFFFF00;
+	static const std::uint16_t PROTOCOL_VERSION = 0x0100;
+	static const std::uint16_t VENDOR_ID = ('C' << 8) | 'M';
+
+	boost::asio::io_service m_ioservice;
+	boost::asio::ip::tcp::socket m_syncSocket; // The synchronous channel
+	boost::asio::ip::tcp::socket m_asyncSocket; // The asynchronous channel
+	std::string m_subAddress; // Name of the device within the instrument, sent when the session is opened
+	std::uint32_t m_messageID; // Message ID of the next command
+	std::uint64_t m_maximumMessageSize; // Largest message which the analyser accepts
+	bool m_responseDelivered; // Set when a complete response has been received, and passed on with the next command
+
+	void sendMessage(boost::asio::ip::tcp::socket &socket, const HiSLIPHeader &header, const char *payload = nullptr);
+	void receiveMessage(boost::asio::ip::tcp::socket &socket, HiSLIPHeader &header, std::string &payload);
+	void receiveData(boost::asio::streambuf &buffer);
+
+public:
+	static const int DEFAULT_PORT = 4880;
+	static const bool STATUS_CHANNEL = true;
+
+	HiSLIPTransport();
+
+	void open(const std::string &ip, int port);
+	void close();
+	bool isOpen();
+
+	std::size_t send(const std::string &data);
+	void fill(boost::asio::streambuf &buffer, std::size_t size);
+	std::size_t fillUntil(boost::asio::streambuf &buffer, char delimiter);
+	bool readStatusByte(unsigned char &status);
+
+	void setSubAddress(const std::string &subAddress);
+	std::string getSubAddress();
+};
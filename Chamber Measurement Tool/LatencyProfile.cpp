@@ -0,0 +1,245 @@
+#include "LatencyProfile.h"
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/ini_parser.hpp>
+#include <algorithm>
+#include <cmath>
+
+/*
+	Returns the time in seconds which has passed since start
+*/
+static double secondsSince(boost::chrono::steady_clock::time_point start) {
+	return boost::chrono::duration<double>(boost::chrono::steady_clock::now() - start).count();
+}
+
+LatencyProfile::LatencyProfile() {
+	commandLatency = 0.5e-3;
+	queryLatency = 2e-3;
+
+	sweepOverhead = 10e-3;
+	pointTime = 20e-6;
+	pointTimeIFBW = 1.2;
+
+	transferRate = 5e6;
+
+	rotatorCommandLatency = 15e-3;
+	moveOverhead = 0.5;
+	moveTimePerDegree = 0.1;
+	rotatorSpeed = 1;
+}
+
+/*
+	Method which returns the time taken by a single sweep
+*/
+double LatencyProfile::getSweepTime(int samplePoints, double IFBW) const {
+	return sweepOverhead + samplePoints * (pointTime + pointTimeIFBW / IFBW);
+}
+
+/*
+	Method which returns the time taken to transfer the data of a trace, i.e. the interleaved real and imaginary values in a binary block.
+	The round trip of the query itself is not included.
+*/
+double LatencyProfile::getTransferTime(int samplePoints, AnalyserDataTransferFormat dtf) const {
+	double bytes = 2.0 * samplePoints * AnalyserDataTransferFormatSize.at(dtf);
+
+	return bytes / transferRate;
+}
+
+/*
+	Method which returns the time taken by the rotator to move through an angle, including accepting the command. Moves which are too
+	small to be sent to the rotator take no time.
+*/
+double LatencyProfile::getMoveTime(double angle) const {
+	angle = std::abs(angle);
+
+	if (angle <= 0.01) {
+		return 0.0;
+	}
+
+	return rotatorCommandLatency + moveOverhead + angle * moveTimePerDegree;
+}
+
+/*
+	Method which reads a profile which was saved with save(). Values which are missing from the file keep their current value
+*/
+bool LatencyProfile::load(const std::string &fileName) {
+	try {
+		boost::property_tree::ptree tree;
+		boost::property_tree::ini_parser::read_ini(fileName, tree);
+
+		commandLatency = tree.get("analyser.commandLatency", commandLatency);
+		queryLatency = tree.get("analyser.queryLatency", queryLatency);
+		sweepOverhead = tree.get("analyser.sweepOverhead", sweepOverhead);
+		pointTime = tree.get("analyser.pointTime", pointTime);
+		pointTimeIFBW = tree.get("analyser.pointTimeIFBW", pointTimeIFBW);
+		transferRate = tree.get("analyser.transferRate", transferRate);
+
+		rotatorCommandLatency = tree.get("rotator.commandLatency", rotatorCommandLatency);
+		moveOverhead = tree.get("rotator.moveOverhead", moveOverhead);
+		moveTimePerDegree = tree.get("rotator.moveTimePerDegree", moveTimePerDegree);
+		rotatorSpeed = tree.get("rotator.speed", rotatorSpeed);
+
+		return true;
+	}
+	catch (boost::property_tree::ptree_error &e) {
+		std::cerr << "Unable to read the latency profile " << fileName << std::endl;
+		std::cerr << "Error Message: " << e.what() << std::endl;
+
+		return false;
+	}
+}
+
+/*
+	Method which writes the profile to an INI file with an [analyser] and a [rotator] section
+*/
+bool LatencyProfile::save(const std::string &fileName) const {
+	try {
+		boost::property_tree::ptree tree;
+
+		tree.put("analyser.commandLatency", commandLatency);
+		tree.put("analyser.queryLatency", queryLatency);
+		tree.put("analyser.sweepOverhead", sweepOverhead);
+		tree.put("analyser.pointTime", pointTime);
+		tree.put("analyser.pointTimeIFBW", pointTimeIFBW);
+		tree.put("analyser.transferRate", transferRate);
+
+		tree.put("rotator.commandLatency", rotatorCommandLatency);
+		tree.put("rotator.moveOverhead", moveOverhead);
+		tree.put("rotator.moveTimePerDegree", moveTimePerDegree);
+		tree.put("rotator.speed", rotatorSpeed);
+
+		boost::property_tree::ini_parser::write_ini(fileName, tree);
+
+		return true;
+	}
+	catch (boost::property_tree::ptree_error &e) {
+		std::cerr << "Unable to write the latency profile " << fileName << std::endl;
+		std::cerr << "Error Message: " << e.what() << std::endl;
+
+		return false;
+	}
+}
+
+/*
+	Method which records a profile on the real instruments.
+	The analyser is timed with two point counts and two IFBWs so that the fixed, per point and IFBW dependent parts of the sweep time can be
+	separated, and the transfer rate follows from the difference in capture time between the two point counts. The rotator is moved back and
+	forth through two different angles to find the fixed and the per degree time of a move, and ends up where it started.
+	The sample points and IFBW of the analyser are restored afterwards.
+*/
+LatencyProfile LatencyProfile::measure(AnalyserObj<double> &analyser, SerialRotatorObj &rotator, int repetitions) {
+	LatencyProfile profile;
+	repetitions = std::max(repetitions, 1);
+
+	const int savedPoints = analyser.getSamplePoints();
+	const double savedIFBW = analyser.getIFBW();
+	const AnalyserDataTransferFormat dtf = analyser.getDataTransferFormat();
+
+	// Round trip of a short query
+	boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+	for (int i = 0; i < repetitions; i++) {
+		analyser.done();
+	}
+
+	profile.queryLatency = secondsSince(start) / repetitions;
+
+	// Commands without a reply, followed by a query to make sure that they have all been processed
+	start = boost::chrono::steady_clock::now();
+
+	for (int i = 0; i < repetitions; i++) {
+		analyser.sendCommand(":TRIG:SOUR EXT");
+	}
+
+	analyser.done();
+	profile.commandLatency = std::max(secondsSince(start) - profile.queryLatency, 0.0) / repetitions;
+
+	// Sweep and capture times for each combination of point count and IFBW
+	const int points[2] = { 201, 1601 };
+	const double IFBW[2] = { savedIFBW, (savedIFBW < 50e3) ? savedIFBW * 10 : savedIFBW / 10 };
+	double sweepTime[2][2];
+	double captureTime[2];
+
+	for (int p = 0; p < 2; p++) {
+		for (int f = 0; f < 2; f++) {
+			// The capture time is only needed at the first IFBW
+			if (p == 0 && f == 1) {
+				continue;
+			}
+
+			analyser.setSamplePoints(points[p]);
+			analyser.setIFBW(IFBW[f]);
+			while (!analyser.done());
+
+			double sweepTotal = 0;
+
+			for (int i = 0; i < repetitions; i++) {
+				analyser.sendCommand(":TRIG:SOUR EXT");
+
+				start = boost::chrono::steady_clock::now();
+				analyser.sendCommand(":TRIG:SING");
+				while (!analyser.done());
+
+				sweepTotal += secondsSince(start) - profile.commandLatency - profile.queryLatency;
+			}
+
+			sweepTime[p][f] = std::max(sweepTotal / repetitions, 0.0);
+
+			if (f == 0) {
+				start = boost::chrono::steady_clock::now();
+
+				for (int i = 0; i < repetitions; i++) {
+					analyser.captureData();
+				}
+
+				captureTime[p] = secondsSince(start) / repetitions;
+			}
+		}
+	}
+
+	double pointTime0 = (sweepTime[1][0] - sweepTime[0][0]) / (points[1] - points[0]);
+	double pointTime1 = (sweepTime[1][1] - (sweepTime[0][0] - points[0] * pointTime0)) / points[1];
+
+	profile.sweepOverhead = std::max(sweepTime[0][0] - points[0] * pointTime0, 0.0);
+	profile.pointTimeIFBW = std::max((pointTime0 - pointTime1) / (1.0 / IFBW[0] - 1.0 / IFBW[1]), 0.0);
+	profile.pointTime = std::max(pointTime0 - profile.pointTimeIFBW / IFBW[0], 0.0);
+
+	// A capture consists of two commands, the sweep, the *OPC? query and the data query, so what remains is the transfer of the data itself
+	double transferTime[2];
+
+	for (int p = 0; p < 2; p++) {
+		transferTime[p] = captureTime[p] - 2 * profile.commandLatency - sweepTime[p][0] - 2 * profile.queryLatency;
+	}
+
+	double bytes = 2.0 * (points[1] - points[0]) * AnalyserDataTransferFormatSize.at(dtf);
+
+	if (transferTime[1] > transferTime[0]) {
+		profile.transferRate = bytes / (transferTime[1] - transferTime[0]);
+	}
+
+	analyser.setSamplePoints(savedPoints);
+	analyser.setIFBW(savedIFBW);
+	while (!analyser.done());
+
+	// The settings round trip of the rotator is used as the time taken to accept a command
+	profile.rotatorSpeed = rotator.getSpeed();
+
+	start = boost::chrono::steady_clock::now();
+	rotator.setSpeed(rotator.getSpeed());
+	profile.rotatorCommandLatency = secondsSince(start);
+
+	// Move through a small and a large angle, there and back, to separate the fixed time from the time per degree
+	const double angles[2] = { 5.0, 45.0 };
+	double moveTime[2];
+
+	for (int a = 0; a < 2; a++) {
+		start = boost::chrono::steady_clock::now();
+		rotator.rotateBy(CLOCKWISE, angles[a]);
+		rotator.rotateBy(ANTICLOCKWISE, angles[a]);
+		moveTime[a] = secondsSince(start) / 2;
+	}
+
+	profile.moveTimePerDegree = std::max((moveTime[1] - moveTime[0]) / (angles[1] - angles[0]), 0.0);
+	profile.moveOverhead = std::max(moveTime[0] - angles[0] * profile.moveTimePerDegree - profile.rotatorCommandLatency, 0.0);
+
+	return profile;
+}
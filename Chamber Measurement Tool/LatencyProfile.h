@@ -0,0 +1,37 @@
+#pragma once
+#include "AnalyserObj.h"
+#include "SerialRotatorObj.h"
+#include <string>
+
+/*
+	Timing model of the instruments, used by CampaignSimulator to predict how long a measurement will take.
+	The default values are typical of the analyser and rotator in the chamber, but a profile should be recorded on the real hardware with
+	measure() and saved to a file, so that campaigns can then be planned from the file without touching the instruments.
+	All times are in seconds.
+*/
+struct LatencyProfile {
+	double commandLatency; // Time taken to send a command which has no reply
+	double queryLatency; // Round trip time of a query with a short reply, e.g. *OPC?
+
+	double sweepOverhead; // Fixed time taken by every sweep, e.g. retrace and band switching
+	double pointTime; // Time spent at every sample point which does not depend on the IFBW
+	double pointTimeIFBW; // Settling time of the IF filter at every sample point, in seconds times Hz: the time per point is this divided by the IFBW
+
+	double transferRate; // Throughput of the binary data blocks in bytes per second
+
+	double rotatorCommandLatency; // Time taken by the rotator controller to accept a move command
+	double moveOverhead; // Fixed time of every move, i.e. acceleration, deceleration and settling of the table
+	double moveTimePerDegree; // Time taken to rotate through a degree at the recorded speed
+	int rotatorSpeed; // Speed setting of the rotator when the profile was recorded
+
+	LatencyProfile();
+
+	double getSweepTime(int samplePoints, double IFBW) const;
+	double getTransferTime(int samplePoints, AnalyserDataTransferFormat dtf) const;
+	double getMoveTime(double angle) const;
+
+	bool load(const std::string &fileName);
+	bool save(const std::string &fileName) const;
+
+	static LatencyProfile measure(AnalyserObj<double> &analyser, SerialRotatorObj &rotator, int repetitions = 5);
+};
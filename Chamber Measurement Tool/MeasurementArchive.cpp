@@ -0,0 +1,494 @@
+#include "MeasurementArchive.h"
+#include "BufferedFileWriter.h"
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+/*
+	Copies a string into a fixed size character field, truncating it if necessary. The field is always null terminated
+*/
+template<std::size_t N> static void copyField(char (&field)[N], const std::string &value) {
+	std::memset(field, 0, N);
+	std::memcpy(field, value.data(), std::min(value.length(), N - 1));
+}
+
+/*
+	Returns a string which can be used as part of a file name. Every character other than a letter, a digit, '-' and '_' is replaced by '_', so
+	that the name cannot leave the archive directory or contain characters which are not allowed in file names
+*/
+static std::string fileNameComponent(const std::string &value) {
+	std::string component = value;
+
+	for (char &c : component) {
+		if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+			c = '_';
+		}
+	}
+
+	return component;
+}
+
+/*
+	Constructor of the ArchiveSlice. The slice covers traceCount traces starting at firstTrace, and pointCount sample points starting at firstPoint.
+	For a compressed file, decoded holds the decoded traces starting at decodedFirstTrace
+*/
+ArchiveSlice::ArchiveSlice(boost::shared_ptr<boost::interprocess::mapped_region> region, const ArchiveIndexEntry &entry, int firstTrace, int traceCount, int firstPoint, int pointCount,
+	boost::shared_ptr<const std::vector<double>> decoded, int decodedFirstTrace)
+	: m_region(region), m_decoded(decoded), m_entry(entry), m_traceCount(traceCount), m_firstPoint(firstPoint), m_pointCount(pointCount) {
+	const char *base = static_cast<const char *>(m_region->get_address());
+	const double *angles = reinterpret_cast<const double *>(base + sizeof(MeasurementFileHeader));
+
+	m_angles = angles + firstTrace;
+
+	if (m_decoded) {
+		m_data = m_decoded->data() + static_cast<std::ptrdiff_t>(firstTrace - decodedFirstTrace) * getTraceStride() + 2 * firstPoint;
+	}
+	else {
+		m_data = angles + entry.traceCount + static_cast<std::ptrdiff_t>(firstTrace) * getTraceStride() + 2 * firstPoint;
+	}
+}
+
+const ArchiveIndexEntry &ArchiveSlice::getEntry() const {
+	return m_entry;
+}
+
+int ArchiveSlice::getTraceCount() const {
+	return m_traceCount;
+}
+
+int ArchiveSlice::getPointCount() const {
+	return m_pointCount;
+}
+
+int ArchiveSlice::getFirstPoint() const {
+	return m_firstPoint;
+}
+
+/*
+	Returns the distance, in doubles, between the start of consecutive traces in the slice
+*/
+std::ptrdiff_t ArchiveSlice::getTraceStride() const {
+	return 2 * static_cast<std::ptrdiff_t>(m_entry.samplePoints);
+}
+
+double ArchiveSlice::getAngle(int trace) const {
+	return m_angles[trace];
+}
+
+/*
+	Returns the frequency of a sample point of the slice. Point 0 is the first point in the slice, not the first point of the full trace
+*/
+double ArchiveSlice::getFrequency(int point) const {
+	if (m_entry.samplePoints < 2) {
+		return m_entry.startFreq;
+	}
+
+	return m_entry.startFreq + (m_firstPoint + point) * (m_entry.stopFreq - m_entry.startFreq) / (m_entry.samplePoints - 1);
+}
+
+/*
+	Returns a pointer to the interleaved real and imaginary data of a trace in the slice. The pointer refers directly to the mapped file
+*/
+const double *ArchiveSlice::getTrace(int trace) const {
+	return m_data + trace * getTraceStride();
+}
+
+/*
+	Constructor of the MeasurementArchive. The directory is created if it does not exist yet, and the index is loaded if it does
+*/
+MeasurementArchive::MeasurementArchive(const std::string &directory) : m_directory(directory), m_compression(false) {
+	boost::filesystem::create_directories(m_directory);
+
+	loadIndex();
+}
+
+/*
+	Loads the index of the archive. An archive without an index is empty
+*/
+bool MeasurementArchive::loadIndex() {
+	m_entries.clear();
+
+	std::ifstream index((boost::filesystem::path(m_directory) / "index.cmi").string(), std::ios::binary);
+
+	if (!index) {
+		return true;
+	}
+
+	ArchiveIndexHeader header;
+
+	if (!index.read(reinterpret_cast<char *>(&header), sizeof(header)) || std::memcmp(header.magic, ARCHIVEINDEX_MAGIC, 4) != 0 || header.version != MEASUREMENTFILE_VERSION) {
+		std::cerr << "The index of the archive in " << m_directory << " is not valid" << std::endl;
+		return false;
+	}
+
+	ArchiveIndexEntry entry;
+
+	while (index.read(reinterpret_cast<char *>(&entry), sizeof(entry))) {
+		m_entries.push_back(entry);
+	}
+
+	return true;
+}
+
+/*
+	Adds an entry to the index file, creating the index if it does not exist yet. An entry for the same measurement file replaces the existing
+	one, since the file has been overwritten, in which case the whole index is written again
+*/
+bool MeasurementArchive::addIndexEntry(const ArchiveIndexEntry &entry) {
+	boost::filesystem::path indexPath = boost::filesystem::path(m_directory) / "index.cmi";
+
+	auto existing = std::find_if(m_entries.begin(), m_entries.end(), [&entry](const ArchiveIndexEntry &other) { return std::strcmp(other.fileName, entry.fileName) == 0; });
+
+	if (existing != m_entries.end()) {
+		std::vector<ArchiveIndexEntry> entries = m_entries;
+		entries[existing - m_entries.begin()] = entry;
+
+		// The new index is written next to the old one and then moved over it, so a failed write leaves the old index intact
+		boost::filesystem::path newIndexPath = boost::filesystem::path(m_directory) / "index.cmi.new";
+		std::ofstream index(newIndexPath.string(), std::ios::binary | std::ios::trunc);
+
+		ArchiveIndexHeader header;
+		std::memcpy(header.magic, ARCHIVEINDEX_MAGIC, 4);
+		header.version = MEASUREMENTFILE_VERSION;
+
+		index.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		index.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(ArchiveIndexEntry));
+		index.close();
+
+		boost::system::error_code ec;
+
+		if (index) {
+			boost::filesystem::rename(newIndexPath, indexPath, ec);
+		}
+
+		if (!index || ec) {
+			std::cerr << "Unable to update the index of the archive in " << m_directory << std::endl;
+			return false;
+		}
+
+		m_entries = entries;
+
+		return true;
+	}
+
+	bool newIndex = !boost::filesystem::exists(indexPath);
+
+	std::ofstream index(indexPath.string(), std::ios::binary | std::ios::app);
+
+	if (newIndex) {
+		ArchiveIndexHeader header;
+		std::memcpy(header.magic, ARCHIVEINDEX_MAGIC, 4);
+		header.version = MEASUREMENTFILE_VERSION;
+
+		index.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	}
+
+	index.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+
+	if (!index) {
+		std::cerr << "Unable to update the index of the archive in " << m_directory << std::endl;
+		return false;
+	}
+
+	m_entries.push_back(entry);
+
+	return true;
+}
+
+/*
+	Decodes the groups of a compressed measurement file which hold the traces from firstTrace up to, but not including, lastTrace.
+	decodedFirstTrace is set to the first trace of the first decoded group. Returns a null pointer if the file is not valid
+*/
+boost::shared_ptr<const std::vector<double>> MeasurementArchive::decodeTraces(const boost::interprocess::mapped_region &region, const ArchiveIndexEntry &entry, int firstTrace, int lastTrace, int &decodedFirstTrace) {
+	const char *base = static_cast<const char *>(region.get_address());
+	const std::size_t size = region.get_size();
+	const std::size_t dataHeaderOffset = sizeof(MeasurementFileHeader) + entry.traceCount * sizeof(double);
+	const std::size_t values = 2 * static_cast<std::size_t>(entry.samplePoints);
+
+	CompressedDataHeader dataHeader;
+	std::memcpy(&dataHeader, base + dataHeaderOffset, sizeof(dataHeader));
+
+	const std::size_t offsetTable = dataHeaderOffset + sizeof(CompressedDataHeader);
+
+	if (dataHeader.groupSize == 0 || dataHeader.groupCount != (entry.traceCount + dataHeader.groupSize - 1) / dataHeader.groupSize
+		|| size < offsetTable + (dataHeader.groupCount + 1) * sizeof(std::uint64_t)) {
+		std::cerr << "The compressed data of the measurement file " << entry.fileName << " is not valid" << std::endl;
+		return boost::shared_ptr<const std::vector<double>>();
+	}
+
+	const std::uint32_t firstGroup = firstTrace / dataHeader.groupSize;
+	const std::uint32_t lastGroup = (lastTrace - 1) / dataHeader.groupSize;
+	const int lastDecodedTrace = std::min<int>(entry.traceCount, (lastGroup + 1) * dataHeader.groupSize);
+
+	decodedFirstTrace = firstGroup * dataHeader.groupSize;
+
+	boost::shared_ptr<std::vector<double>> decoded(new std::vector<double>((lastDecodedTrace - decodedFirstTrace) * values));
+
+	for (std::uint32_t group = firstGroup; group <= lastGroup; group++) {
+		std::uint64_t offsets[2];
+		std::memcpy(offsets, base + offsetTable + group * sizeof(std::uint64_t), sizeof(offsets));
+
+		const int groupFirstTrace = group * dataHeader.groupSize;
+		const int groupTraceCount = std::min<int>(dataHeader.groupSize, entry.traceCount - groupFirstTrace);
+
+		if (offsets[0] > offsets[1] || offsets[1] > size
+			|| !m_codec.decode(base + offsets[0], static_cast<std::size_t>(offsets[1] - offsets[0]), groupTraceCount, entry.samplePoints, decoded->data() + (groupFirstTrace - decodedFirstTrace) * values)) {
+			std::cerr << "The compressed data of the measurement file " << entry.fileName << " is not valid" << std::endl;
+			return boost::shared_ptr<const std::vector<double>>();
+		}
+	}
+
+	return decoded;
+}
+
+/*
+	Method which adds the traces of a campaign to the archive. A measurement file is written for every parameter in the campaign.
+	All the traces of a parameter must share the same frequency points. The model and serial number may be at most 31 characters long; characters
+	which cannot be used in a file name are replaced in the name of the measurement file, but kept in the header and the index.
+*/
+bool MeasurementArchive::addCampaign(const std::string &model, const std::string &serial, std::time_t timestamp, const std::vector<MeasurementTrace> &traces) {
+	// The model and serial number are stored in fixed size fields, a truncated value would no longer match a query
+	if (model.length() >= sizeof(ArchiveIndexEntry::model) || serial.length() >= sizeof(ArchiveIndexEntry::serial)) {
+		std::cerr << "The model and serial number can be at most " << sizeof(ArchiveIndexEntry::model) - 1 << " characters long" << std::endl;
+		return false;
+	}
+
+	std::map<AnalyserParameter, std::vector<const MeasurementTrace *>> tracesByParameter;
+
+	for (const MeasurementTrace &trace : traces) {
+		tracesByParameter[trace.parameter].push_back(&trace);
+	}
+
+	BufferedFileWriter writer;
+
+	for (auto &parameterTraces : tracesByParameter) {
+		std::vector<const MeasurementTrace *> &list = parameterTraces.second;
+		const MeasurementTrace &first = *list.front();
+
+		for (const MeasurementTrace *trace : list) {
+			if (trace->getSamplePoints() != first.getSamplePoints() || trace->startFreq != first.startFreq || trace->stopFreq != first.stopFreq) {
+				std::cerr << "The " << AnalyserParameterToStringMap.at(parameterTraces.first) << " traces do not share the same frequency points" << std::endl;
+				return false;
+			}
+		}
+
+		// The traces are stored in order of angle so that a range of angles can be found with a binary search
+		std::stable_sort(list.begin(), list.end(), [](const MeasurementTrace *a, const MeasurementTrace *b) { return a->angle < b->angle; });
+
+		MeasurementFileHeader header;
+		std::memcpy(header.magic, m_compression ? COMPRESSEDFILE_MAGIC : MEASUREMENTFILE_MAGIC, 4);
+		header.version = MEASUREMENTFILE_VERSION;
+		copyField(header.model, model);
+		copyField(header.serial, serial);
+		header.timestamp = timestamp;
+		header.startFreq = first.startFreq;
+		header.stopFreq = first.stopFreq;
+		header.samplePoints = first.getSamplePoints();
+		header.parameter = parameterTraces.first;
+		header.format = first.format;
+		header.traceCount = static_cast<std::int32_t>(list.size());
+
+		std::string fileName = boost::str(boost::format("%s_%s_%d_%s.cmt") % fileNameComponent(model) % fileNameComponent(serial) % timestamp % AnalyserParameterToStringMap.at(parameterTraces.first));
+
+		if (fileName.length() >= sizeof(ArchiveIndexEntry::fileName)) {
+			std::cerr << "The name of the measurement file " << fileName << " is too long for the index" << std::endl;
+			return false;
+		}
+
+		if (!writer.open((boost::filesystem::path(m_directory) / fileName).string())) {
+			return false;
+		}
+
+		writer.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+		for (const MeasurementTrace *trace : list) {
+			writer.write(reinterpret_cast<const char *>(&trace->angle), sizeof(double));
+		}
+
+		if (m_compression) {
+			// Traces at neighbouring angles are compressed together, so the group is copied into a single block first
+			const std::size_t values = 2 * static_cast<std::size_t>(header.samplePoints);
+
+			CompressedDataHeader dataHeader;
+			dataHeader.groupSize = COMPRESSEDFILE_GROUPSIZE;
+			dataHeader.groupCount = static_cast<std::uint32_t>((list.size() + COMPRESSEDFILE_GROUPSIZE - 1) / COMPRESSEDFILE_GROUPSIZE);
+
+			std::vector<double> group;
+			std::vector<char> encoded;
+			std::vector<std::uint64_t> offsets(1, sizeof(MeasurementFileHeader) + list.size() * sizeof(double) + sizeof(CompressedDataHeader) + (dataHeader.groupCount + 1) * sizeof(std::uint64_t));
+
+			for (std::size_t first = 0; first < list.size(); first += COMPRESSEDFILE_GROUPSIZE) {
+				std::size_t count = std::min<std::size_t>(COMPRESSEDFILE_GROUPSIZE, list.size() - first);
+				group.resize(count * values);
+
+				for (std::size_t t = 0; t < count; t++) {
+					std::copy(list[first + t]->data.begin(), list[first + t]->data.end(), group.begin() + t * values);
+				}
+
+				m_codec.encode(group.data(), count, header.samplePoints, encoded);
+				offsets.push_back(offsets.front() + encoded.size());
+			}
+
+			writer.write(reinterpret_cast<const char *>(&dataHeader), sizeof(dataHeader));
+			writer.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(std::uint64_t));
+			writer.write(encoded.data(), encoded.size());
+		}
+		else {
+			for (const MeasurementTrace *trace : list) {
+				writer.write(reinterpret_cast<const char *>(trace->data.data()), trace->data.size() * sizeof(double));
+			}
+		}
+
+		if (!writer.close()) {
+			return false;
+		}
+
+		ArchiveIndexEntry entry;
+		copyField(entry.fileName, fileName);
+		copyField(entry.model, model);
+		copyField(entry.serial, serial);
+		entry.timestamp = header.timestamp;
+		entry.startFreq = header.startFreq;
+		entry.stopFreq = header.stopFreq;
+		entry.minAngle = list.front()->angle;
+		entry.maxAngle = list.back()->angle;
+		entry.samplePoints = header.samplePoints;
+		entry.parameter = header.parameter;
+		entry.format = header.format;
+		entry.traceCount = header.traceCount;
+
+		if (!addIndexEntry(entry)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+	Method which returns a slice of every measurement file which matches the query. Only the index is searched to find the matching files,
+	after which the files are memory mapped and the requested angle and frequency ranges are located inside them.
+*/
+std::vector<ArchiveSlice> MeasurementArchive::query(const ArchiveQuery &query) {
+	std::vector<ArchiveSlice> slices;
+
+	for (const ArchiveIndexEntry &entry : m_entries) {
+		if (!query.model.empty() && query.model != entry.model) {
+			continue;
+		}
+
+		if (!query.serial.empty() && query.serial != entry.serial) {
+			continue;
+		}
+
+		if (entry.timestamp < query.fromTime || entry.timestamp > query.toTime) {
+			continue;
+		}
+
+		if (!query.parameters.empty() && std::find(query.parameters.begin(), query.parameters.end(), entry.parameter) == query.parameters.end()) {
+			continue;
+		}
+
+		if (entry.stopFreq < query.minFreq || entry.startFreq > query.maxFreq || entry.maxAngle < query.minAngle || entry.minAngle > query.maxAngle) {
+			continue;
+		}
+
+		// Work out which sample points fall inside the requested frequency range
+		int firstPoint = 0;
+		int lastPoint = entry.samplePoints - 1;
+
+		if (entry.samplePoints > 1) {
+			double freqStep = (entry.stopFreq - entry.startFreq) / (entry.samplePoints - 1);
+
+			// Clamped before the conversion to int, since the default limits of the query are infinite
+			firstPoint = static_cast<int>(std::max<double>(firstPoint, std::ceil((query.minFreq - entry.startFreq) / freqStep - 1e-9)));
+			lastPoint = static_cast<int>(std::min<double>(lastPoint, std::floor((query.maxFreq - entry.startFreq) / freqStep + 1e-9)));
+
+			// A range which falls between two sample points, e.g. a single frequency, returns the points on either side of it
+			if (firstPoint > lastPoint) {
+				std::swap(firstPoint, lastPoint);
+			}
+		}
+
+		if (firstPoint > lastPoint) {
+			continue;
+		}
+
+		boost::shared_ptr<boost::interprocess::mapped_region> region;
+
+		try {
+			boost::interprocess::file_mapping file((boost::filesystem::path(m_directory) / entry.fileName).string().c_str(), boost::interprocess::read_only);
+			region.reset(new boost::interprocess::mapped_region(file, boost::interprocess::read_only));
+		}
+		catch (boost::interprocess::interprocess_exception &e) {
+			std::cerr << "Unable to open the measurement file " << entry.fileName << std::endl;
+			std::cerr << "Error Message: " << e.what() << std::endl;
+			continue;
+		}
+
+		const bool compressed = region->get_size() >= 4 && std::memcmp(region->get_address(), COMPRESSEDFILE_MAGIC, 4) == 0;
+		std::size_t expectedSize = sizeof(MeasurementFileHeader) + entry.traceCount * (1 + 2 * static_cast<std::size_t>(entry.samplePoints)) * sizeof(double);
+
+		if (compressed) {
+			expectedSize = sizeof(MeasurementFileHeader) + entry.traceCount * sizeof(double) + sizeof(CompressedDataHeader);
+		}
+
+		if (region->get_size() < expectedSize) {
+			std::cerr << "The measurement file " << entry.fileName << " is shorter than its index entry describes" << std::endl;
+			continue;
+		}
+
+		// The angles are sorted, so the requested range can be found with a binary search
+		const double *angles = reinterpret_cast<const double *>(static_cast<const char *>(region->get_address()) + sizeof(MeasurementFileHeader));
+		const double *firstAngle = std::lower_bound(angles, angles + entry.traceCount, query.minAngle);
+		const double *lastAngle = std::upper_bound(firstAngle, angles + entry.traceCount, query.maxAngle);
+
+		if (firstAngle == lastAngle) {
+			continue;
+		}
+
+		const int firstTrace = static_cast<int>(firstAngle - angles);
+		const int traceCount = static_cast<int>(lastAngle - firstAngle);
+
+		if (compressed) {
+			int decodedFirstTrace;
+			boost::shared_ptr<const std::vector<double>> decoded = decodeTraces(*region, entry, firstTrace, firstTrace + traceCount, decodedFirstTrace);
+
+			if (!decoded) {
+				continue;
+			}
+
+			slices.push_back(ArchiveSlice(region, entry, firstTrace, traceCount, firstPoint, lastPoint - firstPoint + 1, decoded, decodedFirstTrace));
+		}
+		else {
+			slices.push_back(ArchiveSlice(region, entry, firstTrace, traceCount, firstPoint, lastPoint - firstPoint + 1));
+		}
+	}
+
+	return slices;
+}
+
+/*
+	Sets whether the measurement files written by addCampaign are compressed. Both kinds of files can be read, whatever the setting
+*/
+void MeasurementArchive::setCompression(bool compression) {
+	m_compression = compression;
+}
+
+const std::vector<ArchiveIndexEntry> &MeasurementArchive::getEntries() {
+	return m_entries;
+}
+
+std::string MeasurementArchive::getDirectory() {
+	return m_directory;
+}
+
+bool MeasurementArchive::getCompression() {
+	return m_compression;
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include "MeasurementTrace.h"
+#include "TraceCodec.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/shared_ptr.hpp>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <string>
+#include <vector>
+
+/*
+	Binary layout of the measurement files and the index of the archive.
+	A measurement file holds all the traces of a single parameter captured during a campaign. The file starts with a MeasurementFileHeader,
+	followed by the angles of the traces (traceCount doubles, sorted in ascending order) and then the data of the traces
+	(traceCount x samplePoints x 2 doubles, interleaved real and imaginary). Both sections start on an 8 byte boundary so that
+	they can be used directly from a memory mapped file.
+	A compressed measurement file has the same header and angles, with the magic "CMTZ". The data of the traces is split into groups of
+	consecutive angles which are compressed with TraceCodec. The angles are followed by a CompressedDataHeader, the offsets of the groups from the
+	start of the file (groupCount + 1 std::uint64_t, the last one is the end of the last group) and then the groups themselves.
+	The index file holds an ArchiveIndexHeader followed by one ArchiveIndexEntry for every measurement file in the archive.
+*/
+const char MEASUREMENTFILE_MAGIC[4] = { 'C', 'M', 'T', 'F' };
+const char COMPRESSEDFILE_MAGIC[4] = { 'C', 'M', 'T', 'Z' };
+const char ARCHIVEINDEX_MAGIC[4] = { 'C', 'M', 'T', 'I' };
+const std::uint32_t MEASUREMENTFILE_VERSION = 1;
+const std::uint32_t COMPRESSEDFILE_GROUPSIZE = 16; // Number of traces compressed together. Reading a single trace decodes its whole group
+
+#pragma pack(push, 8)
+struct MeasurementFileHeader {
+	char magic[4];
+	std::uint32_t version;
+	char model[32]; // Model of the device under test
+	char serial[32]; // Serial number of the device under test
+	std::int64_t timestamp; // Time at which the campaign was measured, in seconds since the epoch
+	double startFreq;
+	double stopFreq;
+	std::int32_t samplePoints;
+	std::int32_t parameter;
+	std::int32_t format;
+	std::int32_t traceCount;
+};
+
+struct CompressedDataHeader {
+	std::uint32_t groupSize; // Number of traces in every group except possibly the last one
+	std::uint32_t groupCount;
+};
+
+struct ArchiveIndexHeader {
+	char magic[4];
+	std::uint32_t version;
+};
+
+struct ArchiveIndexEntry {
+	char fileName[96]; // Name of the measurement file, relative to the archive directory
+	char model[32];
+	char serial[32];
+	std::int64_t timestamp;
+	double startFreq;
+	double stopFreq;
+	double minAngle; // Smallest angle in the file
+	double maxAngle; // Largest angle in the file
+	std::int32_t samplePoints;
+	std::int32_t parameter;
+	std::int32_t format;
+	std::int32_t traceCount;
+};
+#pragma pack(pop)
+
+/*
+	Structure describing the measurements which should be returned by a query of the archive.
+	Empty strings and the default values match everything.
+*/
+struct ArchiveQuery {
+	std::string model;
+	std::string serial;
+
+	std::int64_t fromTime = std::numeric_limits<std::int64_t>::min();
+	std::int64_t toTime = std::numeric_limits<std::int64_t>::max();
+
+	double minFreq = 0; // Only the sample points from minFreq up to maxFreq are included in the results
+	double maxFreq = std::numeric_limits<double>::infinity();
+
+	double minAngle = -std::numeric_limits<double>::infinity(); // Only the traces from minAngle up to maxAngle are included in the results
+	double maxAngle = std::numeric_limits<double>::infinity();
+
+	std::vector<AnalyserParameter> parameters; // Parameters to return. An empty list returns all parameters
+};
+
+/*
+	Result of a query of the archive. A slice refers directly to the memory mapped measurement file, no data is copied. For a compressed file, the
+	groups which hold the traces of the slice are decoded when the query is made and the slice refers to the decoded data instead.
+	The slice holds the traces with angles in the requested range, restricted to the sample points in the requested frequency range.
+	The mapping is shared, so slices can be copied cheaply and the file stays mapped until the last copy is destroyed.
+*/
+class ArchiveSlice {
+private:
+	boost::shared_ptr<boost::interprocess::mapped_region> m_region; // The memory mapped measurement file
+	boost::shared_ptr<const std::vector<double>> m_decoded; // Decoded traces of a compressed file, null for an uncompressed file
+	ArchiveIndexEntry m_entry; // The index entry of the measurement file
+
+	const double *m_angles; // Angle of the first trace in the slice
+	const double *m_data; // Data of the first sample point of the first trace in the slice
+
+	int m_traceCount; // Number of traces in the slice
+	int m_firstPoint; // Index of the first sample point of the slice in the full trace
+	int m_pointCount; // Number of sample points in the slice
+
+public:
+	ArchiveSlice(boost::shared_ptr<boost::interprocess::mapped_region> region, const ArchiveIndexEntry &entry, int firstTrace, int traceCount, int firstPoint, int pointCount,
+		boost::shared_ptr<const std::vector<double>> decoded = boost::shared_ptr<const std::vector<double>>(), int decodedFirstTrace = 0);
+
+	const ArchiveIndexEntry &getEntry() const;
+	int getTraceCount() const;
+	int getPointCount() const;
+	int getFirstPoint() const;
+	std::ptrdiff_t getTraceStride() const;
+
+	double getAngle(int trace) const;
+	double getFrequency(int point) const;
+	const double *getTrace(int trace) const;
+};
+
+/*
+	Class which manages an archive of measurement files stored in a single directory.
+	Every file is described by an entry in a compact index which is loaded when the archive is opened, which means that queries only need to
+	open the files which actually match, and only the pages of the file which hold the requested slice are read from the disk.
+*/
+class MeasurementArchive {
+private:
+	std::string m_directory; // Directory in which the archive is stored
+	std::vector<ArchiveIndexEntry> m_entries; // The index of the archive
+	bool m_compression; // Whether new measurement files are compressed
+	TraceCodec m_codec;
+
+	bool loadIndex();
+	bool addIndexEntry(const ArchiveIndexEntry &entry);
+	boost::shared_ptr<const std::vector<double>> decodeTraces(const boost::interprocess::mapped_region &region, const ArchiveIndexEntry &entry, int firstTrace, int lastTrace, int &decodedFirstTrace);
+
+public:
+	MeasurementArchive(const std::string &directory);
+
+	bool addCampaign(const std::string &model, const std::string &serial, std::time_t timestamp, const std::vector<MeasurementTrace> &traces);
+	std::vector<ArchiveSlice> query(const ArchiveQuery &query);
+
+	void setCompression(bool compression);
+
+	const std::vector<ArchiveIndexEntry> &getEntries();
+	std::string getDirectory();
+	bool getCompression();
+};
@@ -0,0 +1,327 @@
+#pragma once
+#include "AnalyserObj.h"
+#include "MeasurementTrace.h"
+#include <boost/align/aligned_alloc.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/*
+	Templated container holding all the data of a measurement, i.e. angles x traces x sample points, in a single preallocated block of memory.
+	The real and imaginary values are kept in two separate planes (structure of arrays) rather than interleaved, so that the values of a trace are
+	contiguous and processing along the frequency axis works with unit stride. Every row (the sample points of one trace at one angle) starts on an
+	ALIGNMENT byte boundary, which makes the rows suitable for vectorised kernels.
+	The block is only reallocated when a larger measurement is planned, so a measurement does not allocate any memory once it has started, and the
+	analyser decodes its data straight into the rows (see AnalyserObj::captureInto).
+*/
+template<class T>
+class MeasurementCube {
+public:
+	static const std::size_t ALIGNMENT = 64; // Alignment of every row in bytes, the size of a cache line
+
+	enum Plane {
+		REAL_PLANE,
+		IMAG_PLANE
+	};
+
+	/*
+		View of a series of values spaced a fixed number of elements apart, i.e. a row along frequency (stride 1) or a column along angle
+	*/
+	template<class V>
+	struct StridedView {
+		V *data; // Address of the first value
+		std::size_t count; // Number of values in the view
+		std::size_t stride; // Distance between consecutive values in elements
+
+		V &operator[](std::size_t i) const {
+			return data[i * stride];
+		}
+
+		std::size_t size() const {
+			return count;
+		}
+	};
+
+private:
+	T *m_arena; // The block holding both planes
+	std::size_t m_capacity; // Number of elements the block can hold
+
+	int m_angles; // Number of angles in the measurement
+	int m_traces; // Number of traces captured at each angle
+	int m_samplePoints; // Number of sample points in every trace
+	std::size_t m_rowStride; // Distance between consecutive rows in elements, i.e. the sample points padded to the alignment
+	std::size_t m_planeSize; // Number of elements in a plane, including the padding
+
+	double m_startFreq; // Start frequency of the sweeps
+	double m_stopFreq; // Stop frequency of the sweeps
+	AnalyserFormat m_format; // Format of the data of all the traces
+
+	std::vector<double> m_angleValues; // Position of the rotator at every angle index
+	std::vector<AnalyserParameter> m_parameters; // Parameter measured by every trace index
+
+	T *plane(Plane plane) const;
+
+public:
+	MeasurementCube();
+	MeasurementCube(const MeasurementCube &) = delete;
+	MeasurementCube &operator=(const MeasurementCube &) = delete;
+
+	void allocate(int angles, int traces, int samplePoints);
+	void release();
+
+	/*
+		Setter methods
+	*/
+	void setAngle(int angle, double value);
+	void setParameter(int trace, AnalyserParameter parameter);
+	void setFrequencyRange(double startFreq, double stopFreq);
+	void setFormat(AnalyserFormat format);
+
+	/*
+		Getter methods
+	*/
+	int getAngleCount() const;
+	int getTraceCount() const;
+	int getSamplePoints() const;
+	std::size_t getRowStride() const;
+	std::size_t getAngleStride() const;
+	double getAngle(int angle) const;
+	AnalyserParameter getParameter(int trace) const;
+	double getStartFreq() const;
+	double getStopFreq() const;
+	double getFrequency(int point) const;
+	AnalyserFormat getFormat() const;
+
+	T *real(int angle, int trace);
+	T *imag(int angle, int trace);
+	const T *real(int angle, int trace) const;
+	const T *imag(int angle, int trace) const;
+	const T *getPlane(Plane plane) const;
+
+	StridedView<T> frequencyView(Plane plane, int angle, int trace);
+	StridedView<T> angleView(Plane plane, int trace, int point);
+	StridedView<const T> frequencyView(Plane plane, int angle, int trace) const;
+	StridedView<const T> angleView(Plane plane, int trace, int point) const;
+
+	void getTrace(int angle, int trace, MeasurementTrace &output) const;
+
+	~MeasurementCube();
+};
+
+template<class T> MeasurementCube<T>::MeasurementCube() {
+	m_arena = nullptr;
+	m_capacity = 0;
+	m_angles = 0;
+	m_traces = 0;
+	m_samplePoints = 0;
+	m_rowStride = 0;
+	m_planeSize = 0;
+	m_startFreq = 0;
+	m_stopFreq = 0;
+	m_format = SMIT;
+}
+
+/*
+	Method which sizes the cube for a measurement. The existing block is reused if it is large enough, otherwise a new block is allocated.
+	All values are set to zero, which also makes sure that the memory is paged in before the measurement starts.
+*/
+template<class T> void MeasurementCube<T>::allocate(int angles, int traces, int samplePoints) {
+	const std::size_t rowAlignment = ALIGNMENT / sizeof(T);
+	const std::size_t rowStride = (static_cast<std::size_t>(std::max(samplePoints, 0)) + rowAlignment - 1) / rowAlignment * rowAlignment;
+	const std::size_t planeSize = static_cast<std::size_t>(std::max(angles, 0)) * std::max(traces, 0) * rowStride;
+
+	if (2 * planeSize > m_capacity) {
+		release();
+
+		m_arena = static_cast<T *>(boost::alignment::aligned_alloc(ALIGNMENT, 2 * planeSize * sizeof(T)));
+
+		if (!m_arena) {
+			throw std::bad_alloc();
+		}
+
+		m_capacity = 2 * planeSize;
+	}
+
+	m_angles = std::max(angles, 0);
+	m_traces = std::max(traces, 0);
+	m_samplePoints = std::max(samplePoints, 0);
+	m_rowStride = rowStride;
+	m_planeSize = planeSize;
+
+	std::fill(m_arena, m_arena + 2 * m_planeSize, T(0));
+
+	m_angleValues.assign(m_angles, 0.0);
+	m_parameters.assign(m_traces, S21);
+}
+
+/*
+	Method which frees the block of memory, leaving an empty cube
+*/
+template<class T> void MeasurementCube<T>::release() {
+	if (m_arena) {
+		boost::alignment::aligned_free(m_arena);
+	}
+
+	m_arena = nullptr;
+	m_capacity = 0;
+	m_angles = m_traces = m_samplePoints = 0;
+	m_rowStride = m_planeSize = 0;
+}
+
+template<class T> T *MeasurementCube<T>::plane(Plane plane) const {
+	return (plane == REAL_PLANE) ? m_arena : m_arena + m_planeSize;
+}
+
+/*
+	Methods which return the row holding the real or imaginary values of a trace at an angle. The row holds getSamplePoints() values
+*/
+template<class T> T *MeasurementCube<T>::real(int angle, int trace) {
+	return m_arena + (static_cast<std::size_t>(angle) * m_traces + trace) * m_rowStride;
+}
+
+template<class T> T *MeasurementCube<T>::imag(int angle, int trace) {
+	return m_arena + m_planeSize + (static_cast<std::size_t>(angle) * m_traces + trace) * m_rowStride;
+}
+
+template<class T> const T *MeasurementCube<T>::real(int angle, int trace) const {
+	return m_arena + (static_cast<std::size_t>(angle) * m_traces + trace) * m_rowStride;
+}
+
+template<class T> const T *MeasurementCube<T>::imag(int angle, int trace) const {
+	return m_arena + m_planeSize + (static_cast<std::size_t>(angle) * m_traces + trace) * m_rowStride;
+}
+
+/*
+	Method which returns the start of a plane. The plane is laid out as [angle][trace][point], see getAngleStride() and getRowStride()
+*/
+template<class T> const T *MeasurementCube<T>::getPlane(Plane plane) const {
+	return this->plane(plane);
+}
+
+/*
+	Methods which return the values of a trace at an angle along the frequency axis
+*/
+template<class T> typename MeasurementCube<T>::template StridedView<T> MeasurementCube<T>::frequencyView(Plane plane, int angle, int trace) {
+	StridedView<T> view = { (plane == REAL_PLANE) ? real(angle, trace) : imag(angle, trace), static_cast<std::size_t>(m_samplePoints), 1 };
+	return view;
+}
+
+template<class T> typename MeasurementCube<T>::template StridedView<const T> MeasurementCube<T>::frequencyView(Plane plane, int angle, int trace) const {
+	StridedView<const T> view = { (plane == REAL_PLANE) ? real(angle, trace) : imag(angle, trace), static_cast<std::size_t>(m_samplePoints), 1 };
+	return view;
+}
+
+/*
+	Methods which return the values of a single sample point of a trace along the angle axis, i.e. a cut of the pattern at one frequency
+*/
+template<class T> typename MeasurementCube<T>::template StridedView<T> MeasurementCube<T>::angleView(Plane plane, int trace, int point) {
+	StridedView<T> view = { this->plane(plane) + trace * m_rowStride + point, static_cast<std::size_t>(m_angles), getAngleStride() };
+	return view;
+}
+
+template<class T> typename MeasurementCube<T>::template StridedView<const T> MeasurementCube<T>::angleView(Plane plane, int trace, int point) const {
+	StridedView<const T> view = { this->plane(plane) + trace * m_rowStride + point, static_cast<std::size_t>(m_angles), getAngleStride() };
+	return view;
+}
+
+/*
+	Method which copies a trace at an angle into a MeasurementTrace, interleaving the real and imaginary values again.
+	The data vector of the output is reused, so passing the same object repeatedly does not allocate any memory.
+*/
+template<class T> void MeasurementCube<T>::getTrace(int angle, int trace, MeasurementTrace &output) const {
+	const T *realRow = real(angle, trace);
+	const T *imagRow = imag(angle, trace);
+
+	output.angle = m_angleValues[angle];
+	output.startFreq = m_startFreq;
+	output.stopFreq = m_stopFreq;
+	output.parameter = m_parameters[trace];
+	output.format = m_format;
+	output.data.resize(2 * static_cast<std::size_t>(m_samplePoints));
+
+	for (int i = 0; i < m_samplePoints; i++) {
+		output.data[2 * i] = static_cast<double>(realRow[i]);
+		output.data[2 * i + 1] = static_cast<double>(imagRow[i]);
+	}
+}
+
+template<class T> MeasurementCube<T>::~MeasurementCube() {
+	release();
+}
+
+/*
+	Setter methods
+*/
+
+template<class T> void MeasurementCube<T>::setAngle(int angle, double value) {
+	m_angleValues.at(angle) = value;
+}
+
+template<class T> void MeasurementCube<T>::setParameter(int trace, AnalyserParameter parameter) {
+	m_parameters.at(trace) = parameter;
+}
+
+template<class T> void MeasurementCube<T>::setFrequencyRange(double startFreq, double stopFreq) {
+	m_startFreq = startFreq;
+	m_stopFreq = stopFreq;
+}
+
+template<class T> void MeasurementCube<T>::setFormat(AnalyserFormat format) {
+	m_format = format;
+}
+
+/*
+	Getter methods
+*/
+
+template<class T> int MeasurementCube<T>::getAngleCount() const {
+	return m_angles;
+}
+
+template<class T> int MeasurementCube<T>::getTraceCount() const {
+	return m_traces;
+}
+
+template<class T> int MeasurementCube<T>::getSamplePoints() const {
+	return m_samplePoints;
+}
+
+template<class T> std::size_t MeasurementCube<T>::getRowStride() const {
+	return m_rowStride;
+}
+
+template<class T> std::size_t MeasurementCube<T>::getAngleStride() const {
+	return static_cast<std::size_t>(m_traces) * m_rowStride;
+}
+
+template<class T> double MeasurementCube<T>::getAngle(int angle) const {
+	return m_angleValues.at(angle);
+}
+
+template<class T> AnalyserParameter MeasurementCube<T>::getParameter(int trace) const {
+	return m_parameters.at(trace);
+}
+
+template<class T> double MeasurementCube<T>::getStartFreq() const {
+	return m_startFreq;
+}
+
+template<class T> double MeasurementCube<T>::getStopFreq() const {
+	return m_stopFreq;
+}
+
+/*
+	Returns the frequency of a sample point. The analyser sweeps linearly between the start and the stop frequency
+*/
+template<class T> double MeasurementCube<T>::getFrequency(int point) const {
+	if (m_samplePoints < 2) {
+		return m_startFreq;
+	}
+
+	return m_startFreq + point * (m_stopFreq - m_startFreq) / (m_samplePoints - 1);
+}
+
+template<class T> AnalyserFormat MeasurementCube<T>::getFormat() const {
+	return m_format;
+}
@@ -0,0 +1,283 @@
+#include "MeasurementExporter.h"
+#include "FastFormat.h"
+#include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <map>
+
+/*
+	Returns the path of a file inside a directory. An empty directory refers to the current working directory
+*/
+static std::string joinPath(const std::string &directory, const std::string &fileName) {
+	if (directory.empty()) {
+		return fileName;
+	}
+
+	char last = directory.back();
+
+	if (last == '/' || last == '\\') {
+		return directory + fileName;
+	}
+
+	return directory + "/" + fileName;
+}
+
+/*
+	Constructor of the MeasurementExporter
+*/
+MeasurementExporter::MeasurementExporter(int precision, int threadCount, int tracesPerFile, double referenceImpedance) {
+	setPrecision(precision);
+	setThreadCount(threadCount);
+	setTracesPerFile(tracesPerFile);
+	setReferenceImpedance(referenceImpedance);
+}
+
+/*
+	Method which writes the traces to Touchstone files. The traces are grouped by the angle at which they were captured, and every angle is
+	written to its own file, named <baseName>_<angle>deg.s1p or .s2p
+*/
+bool MeasurementExporter::exportTouchstone(const std::vector<MeasurementTrace> &traces, const std::string &directory, const std::string &baseName) {
+	std::map<double, std::vector<const MeasurementTrace *>> tracesByAngle;
+
+	for (const MeasurementTrace &trace : traces) {
+		tracesByAngle[trace.angle].push_back(&trace);
+	}
+
+	std::vector<ExportJob> jobs;
+	jobs.reserve(tracesByAngle.size());
+
+	for (auto &angleTraces : tracesByAngle) {
+		const char *extension = (angleTraces.second.size() == 1) ? "s1p" : "s2p";
+
+		ExportJob job;
+		job.path = joinPath(directory, boost::str(boost::format("%s_%.2fdeg.%s") % baseName % angleTraces.first % extension));
+		job.traces = std::move(angleTraces.second);
+
+		jobs.push_back(std::move(job));
+	}
+
+	return runJobs(jobs, &MeasurementExporter::writeTouchstoneFile);
+}
+
+/*
+	Method which writes the traces to CSV files. Every parameter is written to its own file, named <baseName>_<parameter>.csv.
+	If the number of traces per file has been limited, the files are split into parts named <baseName>_<parameter>_part<n>.csv
+*/
+bool MeasurementExporter::exportCSV(const std::vector<MeasurementTrace> &traces, const std::string &directory, const std::string &baseName) {
+	std::map<AnalyserParameter, std::vector<const MeasurementTrace *>> tracesByParameter;
+
+	for (const MeasurementTrace &trace : traces) {
+		tracesByParameter[trace.parameter].push_back(&trace);
+	}
+
+	std::vector<ExportJob> jobs;
+
+	for (auto &parameterTraces : tracesByParameter) {
+		const std::string &parameterName = AnalyserParameterToStringMap.at(parameterTraces.first);
+		const std::vector<const MeasurementTrace *> &parameterList = parameterTraces.second;
+
+		if (m_tracesPerFile == 0 || static_cast<int>(parameterList.size()) <= m_tracesPerFile) {
+			ExportJob job;
+			job.path = joinPath(directory, baseName + "_" + parameterName + ".csv");
+			job.traces = parameterList;
+
+			jobs.push_back(std::move(job));
+			continue;
+		}
+
+		for (std::size_t first = 0, part = 1; first < parameterList.size(); first += m_tracesPerFile, part++) {
+			std::size_t last = std::min(first + m_tracesPerFile, parameterList.size());
+
+			ExportJob job;
+			job.path = joinPath(directory, boost::str(boost::format("%s_%s_part%03d.csv") % baseName % parameterName % part));
+			job.traces.assign(parameterList.begin() + first, parameterList.begin() + last);
+
+			jobs.push_back(std::move(job));
+		}
+	}
+
+	return runJobs(jobs, &MeasurementExporter::writeCSVFile);
+}
+
+/*
+	Method which writes the files described by the jobs. The jobs are shared between the worker threads, each of which takes the next
+	job which has not been started yet until all the jobs are done. Every worker has its own output buffer.
+*/
+bool MeasurementExporter::runJobs(const std::vector<ExportJob> &jobs, FileWriteMethod writeMethod) {
+	std::atomic<std::size_t> nextJob(0);
+	std::atomic<bool> success(true);
+
+	auto worker = [&]() {
+		BufferedFileWriter writer;
+
+		for (std::size_t job = nextJob++; job < jobs.size(); job = nextJob++) {
+			if (!writer.open(jobs[job].path) || !(this->*writeMethod)(writer, jobs[job]) || !writer.close()) {
+				writer.close();
+				success = false;
+			}
+		}
+	};
+
+	int threadCount = m_threadCount;
+
+	if (threadCount == 0) {
+		threadCount = std::max(1u, boost::thread::hardware_concurrency());
+	}
+
+	threadCount = std::min(threadCount, static_cast<int>(jobs.size()));
+
+	// A single file is written on the calling thread, there is no point in starting a thread for it
+	if (threadCount <= 1) {
+		worker();
+		return success;
+	}
+
+	boost::thread_group workers;
+
+	for (int i = 0; i < threadCount; i++) {
+		workers.create_thread(worker);
+	}
+
+	workers.join_all();
+
+	return success;
+}
+
+/*
+	Method which writes the traces captured at a single angle to a Touchstone file.
+	Only data in the SMIT format is written, as real and imaginary pairs (RI). The other formats do not hold the phase of the parameters, which a
+	Touchstone file cannot leave out, so they can only be exported to CSV.
+*/
+bool MeasurementExporter::writeTouchstoneFile(BufferedFileWriter &writer, const ExportJob &job) {
+	const MeasurementTrace &first = *job.traces.front();
+
+	// All the traces in the file must share the same frequency points and format
+	for (const MeasurementTrace *trace : job.traces) {
+		if (trace->format != first.format || trace->getSamplePoints() != first.getSamplePoints() || trace->startFreq != first.startFreq || trace->stopFreq != first.stopFreq) {
+			std::cerr << "The traces written to " << job.path << " do not share the same frequency points and format" << std::endl;
+			return false;
+		}
+	}
+
+	if (first.format != SMIT) {
+		std::cerr << "Data in the " << AnalyserFormatToStringMap.at(first.format) << " format cannot be written to a Touchstone file, use the SMIT format or export to CSV" << std::endl;
+		return false;
+	}
+
+	// Touchstone files list the 2-port parameters in the order S11, S21, S12, S22. A 1-port file only holds the single measured trace
+	std::vector<const MeasurementTrace *> columns;
+
+	if (job.traces.size() == 1) {
+		columns.push_back(&first);
+	}
+	else {
+		const AnalyserParameter order[] = { S11, S21, S12, S22 };
+
+		for (AnalyserParameter parameter : order) {
+			auto match = std::find_if(job.traces.begin(), job.traces.end(), [parameter](const MeasurementTrace *trace) { return trace->parameter == parameter; });
+			columns.push_back((match != job.traces.end()) ? *match : nullptr);
+		}
+	}
+
+	std::string header = boost::str(boost::format("! Chamber Measurement Tool export\n! Angle: %.2f deg\n") % first.angle);
+
+	if (job.traces.size() == 1) {
+		header += "! Parameter: " + AnalyserParameterToStringMap.at(first.parameter) + "\n";
+	}
+
+	header += boost::str(boost::format("# HZ S RI R %g\n") % m_referenceImpedance);
+	writer.write(header);
+
+	int samplePoints = first.getSamplePoints();
+
+	for (int point = 0; point < samplePoints; point++) {
+		char *out = writer.reserve((2 * columns.size() + 1) * (FASTFORMAT_MAXLENGTH + 1) + 1);
+
+		out = formatFixed(out, first.getFrequency(point), 0);
+
+		for (const MeasurementTrace *column : columns) {
+			double real = column ? column->data[2 * point] : 0.0;
+			double imag = column ? column->data[2 * point + 1] : 0.0;
+
+			*out++ = ' ';
+			out = formatScientific(out, real, m_precision);
+			*out++ = ' ';
+			out = formatScientific(out, imag, m_precision);
+		}
+
+		*out++ = '\n';
+		writer.commit(out);
+	}
+
+	return true;
+}
+
+/*
+	Method which writes traces to a CSV file, with a row for every angle and frequency
+*/
+bool MeasurementExporter::writeCSVFile(BufferedFileWriter &writer, const ExportJob &job) {
+	writer.write(std::string("Angle,Frequency,Real,Imaginary\n"));
+
+	for (const MeasurementTrace *trace : job.traces) {
+		int samplePoints = trace->getSamplePoints();
+
+		for (int point = 0; point < samplePoints; point++) {
+			char *out = writer.reserve(4 * (FASTFORMAT_MAXLENGTH + 1));
+
+			out = formatFixed(out, trace->angle, 2);
+			*out++ = ',';
+			out = formatFixed(out, trace->getFrequency(point), 0);
+			*out++ = ',';
+			out = formatScientific(out, trace->data[2 * point], m_precision);
+			*out++ = ',';
+			out = formatScientific(out, trace->data[2 * point + 1], m_precision);
+			*out++ = '\n';
+
+			writer.commit(out);
+		}
+	}
+
+	return true;
+}
+
+/*
+	Setter methods
+*/
+
+void MeasurementExporter::setPrecision(int precision) {
+	m_precision = std::min(std::max(precision, 0), FASTFORMAT_MAXPRECISION);
+}
+
+void MeasurementExporter::setThreadCount(int threadCount) {
+	m_threadCount = std::max(threadCount, 0);
+}
+
+void MeasurementExporter::setTracesPerFile(int tracesPerFile) {
+	m_tracesPerFile = std::max(tracesPerFile, 0);
+}
+
+void MeasurementExporter::setReferenceImpedance(double referenceImpedance) {
+	m_referenceImpedance = referenceImpedance;
+}
+
+/*
+	Getter methods
+*/
+
+int MeasurementExporter::getPrecision() {
+	return m_precision;
+}
+
+int MeasurementExporter::getThreadCount() {
+	return m_threadCount;
+}
+
+int MeasurementExporter::getTracesPerFile() {
+	return m_tracesPerFile;
+}
+
+double MeasurementExporter::getReferenceImpedance() {
+	return m_referenceImpedance;
+}
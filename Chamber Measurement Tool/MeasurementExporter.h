@@ -0,0 +1,54 @@
+#pragma once
+#include "MeasurementTrace.h"
+#include "BufferedFileWriter.h"
+#include <string>
+#include <vector>
+
+/*
+	Class which exports captured traces to file formats which can be read by other tools.
+	Two formats are supported:
+	- Touchstone (.s1p/.s2p): One file is written for every rotator position. If only a single parameter was measured at a position a .s1p file
+	  is written, otherwise a .s2p file containing S11, S21, S12 and S22 is written. Parameters which were not measured are written as 0.
+	  Only traces captured in the SMIT format can be written, since the other formats do not hold the phase.
+	- CSV: One file is written for every measured parameter, with a row for every angle and frequency. Large campaigns can be split into
+	  multiple files by limiting the number of traces written to each file.
+	The files are written in parallel by a number of worker threads, each of which formats its output into a large buffer which is written to
+	the disk in big blocks.
+*/
+class MeasurementExporter {
+private:
+	int m_precision; // Number of digits written after the decimal point of each data value
+	int m_threadCount; // Number of threads used to write the files. A value of 0 uses one thread per processor core
+	int m_tracesPerFile; // Maximum number of traces written to a single CSV file. A value of 0 writes all the traces of a parameter to a single file
+	double m_referenceImpedance; // Reference impedance written in the Touchstone option line
+
+	/*
+		Structure which describes a single file which needs to be written
+	*/
+	struct ExportJob {
+		std::string path;
+		std::vector<const MeasurementTrace *> traces;
+	};
+
+	typedef bool (MeasurementExporter::*FileWriteMethod)(BufferedFileWriter &writer, const ExportJob &job);
+
+	bool runJobs(const std::vector<ExportJob> &jobs, FileWriteMethod writeMethod);
+	bool writeTouchstoneFile(BufferedFileWriter &writer, const ExportJob &job);
+	bool writeCSVFile(BufferedFileWriter &writer, const ExportJob &job);
+
+public:
+	MeasurementExporter(int precision = 6, int threadCount = 0, int tracesPerFile = 0, double referenceImpedance = 50);
+
+	bool exportTouchstone(const std::vector<MeasurementTrace> &traces, const std::string &directory, const std::string &baseName);
+	bool exportCSV(const std::vector<MeasurementTrace> &traces, const std::string &directory, const std::string &baseName);
+
+	void setPrecision(int precision = 6);
+	void setThreadCount(int threadCount = 0);
+	void setTracesPerFile(int tracesPerFile = 0);
+	void setReferenceImpedance(double referenceImpedance = 50);
+
+	int getPrecision();
+	int getThreadCount();
+	int getTracesPerFile();
+	double getReferenceImpedance();
+};
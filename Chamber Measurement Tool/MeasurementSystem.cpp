@@ -1,14 +1,16 @@
 #include "MeasurementSystem.h"
+#include "SerialRotatorException.h"
+#include <algorithm>
+#include <cmath>
+
+MeasurementSystem::MeasurementSystem(AnalyserObj<double> *analyser, SerialRotatorObj *rotator){
+	m_capturedTraces = 0;
 
-MeasurementSystem::MeasurementSystem(AnalyserObj<double> *analyser = nullptr, SerialRotatorObj *rotator = nullptr){
-	
 	if (!analyser) {
 		std::cout << "The analyser object is not pointing to anything. No analyser object was assigned to the MeasurementSystem object" << std::endl;
-		std::cout << "The rotator object is not pointing to anything. No rotator object was assigned to the MeasurementSystem object" << std::endl;
 	}
 	else {
 		this->analyser.reset(analyser);
-		return;
 	}
 	
 	if (!rotator) {
@@ -16,7 +18,264 @@ MeasurementSystem::MeasurementSystem(AnalyserObj<double> *analyser = nullptr, Se
 	}
 	else {
 		this->rotator.reset(rotator);
-		return;
 	}
 
-}
\ No newline at end of file
+}
+
+/*
+	Method which measures a cut of the antenna pattern. The rotator is moved from the start angle to the stop angle in increments of the step angle
+	of the rotator, and each of the requested parameters is captured at every position.
+	The captured traces replace the traces of the previous measurement. Returns false if the measurement could not be completed.
+	The measurement cube is sized for the whole cut before the rotator starts moving, and the analyser decodes every trace straight into it.
+	If a gain calibration is set, it is prepared for the sweeps before the rotator starts moving and every transmission trace is corrected in the
+	cube as soon as it has been captured, so the published traces and the cube hold the absolute gain.
+	The parameters are measured with as few sweeps as possible (see planSweeps()). When the switch matrix is used, the switch starts moving to
+	the path of the next sweep as soon as a sweep has finished, so it settles while the data of the sweep is transferred, and the path of the
+	first sweep is selected while the rotator moves.
+*/
+bool MeasurementSystem::measureCut(double startAngle, double stopAngle, const std::vector<AnalyserParameter> &parameters) {
+	if (!analyser || !rotator) {
+		std::cerr << "Both an analyser and a rotator are needed to measure a cut" << std::endl;
+		return false;
+	}
+
+	double stepAngle = rotator->getStepAngle();
+	int positions = static_cast<int>(std::floor(std::abs(stopAngle - startAngle) / stepAngle + 1e-9)) + 1;
+	double direction = (stopAngle < startAngle) ? -1.0 : 1.0;
+
+	m_cube.allocate(positions, static_cast<int>(parameters.size()), analyser->getSamplePoints());
+	m_cube.setFrequencyRange(analyser->getStartFreq(), analyser->getStopFreq());
+	m_cube.setFormat(analyser->getFormat());
+
+	for (std::size_t i = 0; i < parameters.size(); i++) {
+		m_cube.setParameter(static_cast<int>(i), parameters[i]);
+	}
+
+	if (calibration && !calibration->prepare(m_cube.getStartFreq(), m_cube.getStopFreq(), m_cube.getSamplePoints())) {
+		std::cerr << "Unable to prepare the gain calibration for the measurement" << std::endl;
+		return false;
+	}
+
+	m_capturedTraces = 0;
+
+	if (plotDecimator) {
+		plotDecimator->clear();
+	}
+
+	if (!planSweeps(parameters)) {
+		std::cerr << "Unable to set up the traces of the analyser" << std::endl;
+		return false;
+	}
+
+	for (int position = 0; position < positions; position++) {
+		double angle = startAngle + direction * position * stepAngle;
+
+		// Switch to the path of the first sweep while the rotator moves
+		std::shared_future<void> selection = selectPath(m_sweeps.empty() ? -1 : m_sweeps.front().path);
+
+		try {
+			rotator->rotateTo(angle);
+		}
+		catch (SerialRotatorException &e) {
+			std::cerr << "Unable to move the rotator to " << angle << " degrees: " << e.what() << std::endl;
+			return false;
+		}
+
+		m_cube.setAngle(position, angle);
+
+		for (std::size_t sweep = 0; sweep < m_sweeps.size(); sweep++) {
+			const PlannedSweep &planned = m_sweeps[sweep];
+
+			try {
+				selection.get();
+			}
+			catch (boost::system::system_error &e) {
+				std::cerr << "Unable to select path " << planned.path << " of the switch matrix at " << angle << " degrees: " << e.what() << std::endl;
+				return false;
+			}
+
+			if (!analyser->triggerSweep()) {
+				std::cerr << "Unable to sweep at " << angle << " degrees" << std::endl;
+				return false;
+			}
+
+			// The switch settles while the traces of this sweep are transferred
+			if (sweep + 1 < m_sweeps.size()) {
+				selection = selectPath(m_sweeps[sweep + 1].path);
+			}
+
+			for (std::size_t i = 0; i < planned.cubeTraces.size(); i++) {
+				int trace = planned.cubeTraces[i];
+				AnalyserParameter parameter = m_cube.getParameter(trace);
+
+				if (!analyser->transferInto(m_cube.real(position, trace), m_cube.imag(position, trace), 1, planned.analyserTraces[i])) {
+					std::cerr << "Unable to capture " << AnalyserParameterToStringMap.at(parameter) << " at " << angle << " degrees" << std::endl;
+					return false;
+				}
+
+				if (calibration && calibration->appliesTo(parameter)) {
+					calibration->apply(m_cube.getFormat(), m_cube.real(position, trace), m_cube.imag(position, trace));
+				}
+
+				if (streamServer || plotDecimator) {
+					m_cube.getTrace(position, trace, m_publishedTrace);
+				}
+
+				if (streamServer) {
+					streamServer->publish(m_publishedTrace);
+				}
+
+				if (plotDecimator) {
+					plotDecimator->addTrace(m_publishedTrace);
+				}
+			}
+		}
+
+		m_capturedTraces += m_cube.getTraceCount();
+	}
+
+	return true;
+}
+
+/*
+	Method which works out the sweeps taken at every position and sets up the traces of the analyser for them.
+	Every distinct parameter which the analyser measures gets a trace of its own, so a single sweep measures all of them, e.g. S21 and S31 on an
+	analyser with a second receive port. The parameters which are routed through the switch matrix are grouped by path, and every path is swept
+	separately, transferring the traces of the parameters routed to it. The routes are ignored if there is no switch matrix.
+*/
+bool MeasurementSystem::planSweeps(const std::vector<AnalyserParameter> &parameters) {
+	std::vector<AnalyserParameter> measured; // The parameter of every trace of the analyser
+
+	m_sweeps.clear();
+
+	for (std::size_t i = 0; i < parameters.size(); i++) {
+		int path = -1;
+		AnalyserParameter parameter = parameters[i];
+
+		auto route = m_routes.find(parameter);
+
+		if (switchMatrix && route != m_routes.end()) {
+			path = route->second.path;
+			parameter = route->second.measured;
+		}
+
+		auto analyserTrace = std::find(measured.begin(), measured.end(), parameter);
+
+		if (analyserTrace == measured.end()) {
+			analyserTrace = measured.insert(measured.end(), parameter);
+		}
+
+		auto sweep = std::find_if(m_sweeps.begin(), m_sweeps.end(), [path](const PlannedSweep &planned) { return planned.path == path; });
+
+		if (sweep == m_sweeps.end()) {
+			PlannedSweep planned;
+			planned.path = path;
+			sweep = m_sweeps.insert(m_sweeps.end(), planned);
+		}
+
+		sweep->cubeTraces.push_back(static_cast<int>(i));
+		sweep->analyserTraces.push_back(static_cast<int>(analyserTrace - measured.begin()) + 1);
+	}
+
+	// Always sent, since the analyser keeps the traces of an earlier cut which measured more parameters and would sweep them all
+	if (!analyser->setTraceCount(static_cast<int>(measured.size()))) {
+		return false;
+	}
+
+	for (std::size_t trace = 0; trace < measured.size(); trace++) {
+		if (!analyser->setParameter(measured[trace], 1, static_cast<int>(trace) + 1)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+	Method which starts selecting a path of the switch matrix. Returns a future which is already ready if the path is -1, i.e. the sweep does not
+	use the switch matrix
+*/
+std::shared_future<void> MeasurementSystem::selectPath(int path) {
+	if (path < 0 || !switchMatrix) {
+		std::promise<void> selected;
+		selected.set_value();
+
+		return selected.get_future().share();
+	}
+
+	return switchMatrix->selectPathAsync(path);
+}
+
+/*
+	Method which sets the server to which every captured trace is published as soon as it has been captured.
+	The measurement system takes ownership of the server. Passing a nullptr stops the publishing of traces.
+*/
+void MeasurementSystem::setStreamServer(SweepStreamServer *streamServer) {
+	this->streamServer.reset(streamServer);
+}
+
+/*
+	Method which sets the level of detail data which is updated with every captured trace, for use by a display.
+	The measurement system takes ownership of the object. It is cleared at the start of every measurement.
+*/
+void MeasurementSystem::setPlotDecimator(PlotDecimator *plotDecimator) {
+	this->plotDecimator.reset(plotDecimator);
+}
+
+PlotDecimator *MeasurementSystem::getPlotDecimator() {
+	return plotDecimator.get();
+}
+
+/*
+	Method which sets the gain calibration which is applied to every captured transmission trace.
+	The measurement system takes ownership of the calibration. Passing a nullptr stores the traces as measured.
+*/
+void MeasurementSystem::setCalibration(GainCalibration *calibration) {
+	this->calibration.reset(calibration);
+}
+
+GainCalibration *MeasurementSystem::getCalibration() {
+	return calibration.get();
+}
+
+/*
+	Method which sets the switch matrix used to measure the parameters which have a route (see setSwitchRoute()).
+	The measurement system takes ownership of the switch matrix. Passing a nullptr measures every parameter on the analyser directly.
+*/
+void MeasurementSystem::setSwitchMatrix(SerialSwitchMatrix *switchMatrix) {
+	this->switchMatrix.reset(switchMatrix);
+}
+
+SerialSwitchMatrix *MeasurementSystem::getSwitchMatrix() {
+	return switchMatrix.get();
+}
+
+/*
+	Method which routes a parameter through the switch matrix: the parameter is captured by selecting the path and measuring the given parameter
+	on the analyser, and is stored in the measurement under its own name. E.g. with both polarisations of the probe switched to port 2:
+		setSwitchRoute(S21, 1, S21); // co-polar
+		setSwitchRoute(S31, 2, S21); // cross-polar
+*/
+void MeasurementSystem::setSwitchRoute(AnalyserParameter parameter, int path, AnalyserParameter measured) {
+	SwitchRoute route = { path, measured };
+	m_routes[parameter] = route;
+}
+
+void MeasurementSystem::clearSwitchRoutes() {
+	m_routes.clear();
+}
+
+/*
+	Method which returns the data captured during the last measurement
+*/
+const MeasurementCube<double> &MeasurementSystem::getCube() {
+	return m_cube;
+}
+
+/*
+	Method which returns the number of traces captured during the last measurement. The traces are stored in the cube angle by angle, so trace i
+	is at angle i / getCube().getTraceCount() and trace index i % getCube().getTraceCount()
+*/
+int MeasurementSystem::getCapturedTraceCount() {
+	return m_capturedTraces;
+}
@@ -1,13 +1,61 @@
 #pragma once
 #include "AnalyserObj.h"
 #include "SerialRotatorObj.h"
+#include "MeasurementTrace.h"
+#include "MeasurementCube.h"
+#include "SweepStreamServer.h"
+#include "PlotDecimator.h"
+#include "GainCalibration.h"
+#include "SerialSwitchMatrix.h"
+#include <future>
+#include <map>
+#include <vector>
 
 class MeasurementSystem {
 private:
+	/*
+		A sweep taken at every position, with the traces which are transferred from it. The parameters which are not routed through the switch
+		matrix share a single sweep, and every path of the switch matrix needs a sweep of its own
+	*/
+	struct PlannedSweep {
+		int path; // Path of the switch matrix, -1 if the switch matrix is not used
+		std::vector<int> cubeTraces; // Index in the cube of every trace transferred from the sweep
+		std::vector<int> analyserTraces; // Trace number on the analyser of every trace transferred from the sweep
+	};
+
 	boost::scoped_ptr<AnalyserObj<double>> analyser;
 	boost::scoped_ptr<SerialRotatorObj> rotator;
+	boost::scoped_ptr<SweepStreamServer> streamServer; // Optional server to which every captured trace is published
+	boost::scoped_ptr<PlotDecimator> plotDecimator; // Optional level of detail data for displaying the traces while they are measured
+	boost::scoped_ptr<GainCalibration> calibration; // Optional gain calibration applied to every captured trace
+	boost::scoped_ptr<SerialSwitchMatrix> switchMatrix; // Optional switch matrix which routes the receive antennas to the analyser
+
+	std::map<AnalyserParameter, SwitchRoute> m_routes; // Parameters which are measured through the switch matrix
+	std::vector<PlannedSweep> m_sweeps; // The sweeps taken at every position of the current measurement
+
+	MeasurementCube<double> m_cube; // The data captured during the last measurement
+	int m_capturedTraces; // Number of traces in the cube which have been captured, in the order angle by angle. Only complete positions are counted
+
+	MeasurementTrace m_publishedTrace; // Reused to hand each captured trace to the stream server and the plot decimator
+
+	bool planSweeps(const std::vector<AnalyserParameter> &parameters);
+	std::shared_future<void> selectPath(int path);
 
 public:
-	MeasurementSystem(AnalyserObj<double> *analyser, SerialRotatorObj *rotator);
+	MeasurementSystem(AnalyserObj<double> *analyser = nullptr, SerialRotatorObj *rotator = nullptr);
+
+	bool measureCut(double startAngle, double stopAngle, const std::vector<AnalyserParameter> &parameters = { S21 });
+
+	void setStreamServer(SweepStreamServer *streamServer);
+	void setPlotDecimator(PlotDecimator *plotDecimator);
+	PlotDecimator *getPlotDecimator();
+	void setCalibration(GainCalibration *calibration);
+	GainCalibration *getCalibration();
+	void setSwitchMatrix(SerialSwitchMatrix *switchMatrix);
+	SerialSwitchMatrix *getSwitchMatrix();
+	void setSwitchRoute(AnalyserParameter parameter, int path, AnalyserParameter measured = S21);
+	void clearSwitchRoutes();
 
-};
\ No newline at end of file
+	const MeasurementCube<double> &getCube();
+	int getCapturedTraceCount();
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include "AnalyserObj.h"
+#include <vector>
+
+/*
+	Structure which holds a single trace captured by the analyser, together with the settings which were in use when it was captured.
+	The data is stored exactly as it is returned by AnalyserObj::captureData, i.e. interleaved real and imaginary values, 2 values per sample point.
+*/
+struct MeasurementTrace {
+	double angle; // Position of the rotator, in degrees, at which the trace was captured
+	double startFreq; // Start frequency of the sweep
+	double stopFreq; // Stop frequency of the sweep
+
+	AnalyserParameter parameter; // The S-parameter which was measured
+	AnalyserFormat format; // The format of the data, i.e. MLOG, PHAS, etc...
+
+	std::vector<double> data; // Interleaved real and imaginary data
+
+	/*
+		Returns the number of sample points in the trace
+	*/
+	int getSamplePoints() const {
+		return static_cast<int>(data.size() / 2);
+	}
+
+	/*
+		Returns the frequency of a sample point. The analyser sweeps linearly between the start and the stop frequency
+	*/
+	double getFrequency(int point) const {
+		int samplePoints = getSamplePoints();
+
+		if (samplePoints < 2) {
+			return startFreq;
+		}
+
+		return startFreq + point * (stopFreq - startFreq) / (samplePoints - 1);
+	}
+};
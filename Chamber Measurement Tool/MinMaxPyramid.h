@@ -0,0 +1,165 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/*
+	Templated multi-resolution min/max pyramid of a series of values, used to draw large data sets quickly.
+	Level 0 holds the values themselves, and every level above it holds the minimum and maximum of pairs of entries of the level below, i.e.
+	an entry of level k covers 2^k values. The min/max envelope of any range of values can therefore be found by combining a handful of entries,
+	which means that drawing a plot takes time proportional to the number of pixels, not the number of values.
+	Values can be appended one at a time, which updates a single entry on each level.
+*/
+template<class T>
+class MinMaxPyramid {
+private:
+	std::vector<T> m_values; // Level 0 of the pyramid
+	std::vector<std::vector<T>> m_min; // m_min[k - 1] holds the minimums of level k
+	std::vector<std::vector<T>> m_max; // m_max[k - 1] holds the maximums of level k
+
+	void rangeMinMax(std::size_t first, std::size_t last, T &minValue, T &maxValue) const;
+
+public:
+	void append(T value);
+	void assign(const T *values, std::size_t count, std::size_t stride = 1);
+	void clear();
+
+	std::size_t size() const;
+	std::size_t query(std::size_t first, std::size_t last, std::size_t buckets, T *minValues, T *maxValues) const;
+};
+
+/*
+	Method which appends a value to the series and updates the entry covering it on every level
+*/
+template<class T> void MinMaxPyramid<T>::append(T value) {
+	std::size_t index = m_values.size();
+	m_values.push_back(value);
+
+	for (std::size_t level = 1; (std::size_t(1) << (level - 1)) < m_values.size(); level++) {
+		if (m_min.size() < level) {
+			// A new level is needed. Its first entry covers the values which already exist
+			m_min.push_back(std::vector<T>(1, m_min.empty() ? std::min(m_values[0], m_values[1]) : std::min(m_min.back()[0], m_min.back()[1])));
+			m_max.push_back(std::vector<T>(1, m_max.empty() ? std::max(m_values[0], m_values[1]) : std::max(m_max.back()[0], m_max.back()[1])));
+			continue;
+		}
+
+		std::vector<T> &minLevel = m_min[level - 1];
+		std::vector<T> &maxLevel = m_max[level - 1];
+		std::size_t entry = index >> level;
+
+		if (entry == minLevel.size()) {
+			minLevel.push_back(value);
+			maxLevel.push_back(value);
+		}
+		else {
+			minLevel[entry] = std::min(minLevel[entry], value);
+			maxLevel[entry] = std::max(maxLevel[entry], value);
+		}
+	}
+}
+
+/*
+	Method which replaces the series with the given values and rebuilds the pyramid. The stride is the distance between consecutive values,
+	which allows e.g. the real parts of interleaved complex data to be used directly
+*/
+template<class T> void MinMaxPyramid<T>::assign(const T *values, std::size_t count, std::size_t stride) {
+	m_values.resize(count);
+
+	for (std::size_t i = 0; i < count; i++) {
+		m_values[i] = values[i * stride];
+	}
+
+	m_min.clear();
+	m_max.clear();
+
+	const T *minBelow = m_values.data();
+	const T *maxBelow = m_values.data();
+	std::size_t countBelow = count;
+
+	while (countBelow > 1) {
+		std::size_t levelCount = (countBelow + 1) / 2;
+
+		m_min.push_back(std::vector<T>(levelCount));
+		m_max.push_back(std::vector<T>(levelCount));
+
+		std::vector<T> &minLevel = m_min.back();
+		std::vector<T> &maxLevel = m_max.back();
+
+		for (std::size_t i = 0; i < countBelow / 2; i++) {
+			minLevel[i] = std::min(minBelow[2 * i], minBelow[2 * i + 1]);
+			maxLevel[i] = std::max(maxBelow[2 * i], maxBelow[2 * i + 1]);
+		}
+
+		if (countBelow % 2) {
+			minLevel[levelCount - 1] = minBelow[countBelow - 1];
+			maxLevel[levelCount - 1] = maxBelow[countBelow - 1];
+		}
+
+		minBelow = minLevel.data();
+		maxBelow = maxLevel.data();
+		countBelow = levelCount;
+	}
+}
+
+template<class T> void MinMaxPyramid<T>::clear() {
+	m_values.clear();
+	m_min.clear();
+	m_max.clear();
+}
+
+template<class T> std::size_t MinMaxPyramid<T>::size() const {
+	return m_values.size();
+}
+
+/*
+	Method which finds the minimum and maximum of the values from first up to, but not including, last.
+	The range is covered with the largest aligned entries which fit inside it, so only a few entries of each level are visited
+*/
+template<class T> void MinMaxPyramid<T>::rangeMinMax(std::size_t first, std::size_t last, T &minValue, T &maxValue) const {
+	minValue = m_values[first];
+	maxValue = m_values[first];
+
+	while (first < last) {
+		std::size_t level = 0;
+
+		while (level < m_min.size() && (first & ((std::size_t(2) << level) - 1)) == 0 && first + (std::size_t(2) << level) <= last) {
+			level++;
+		}
+
+		if (level == 0) {
+			minValue = std::min(minValue, m_values[first]);
+			maxValue = std::max(maxValue, m_values[first]);
+		}
+		else {
+			minValue = std::min(minValue, m_min[level - 1][first >> level]);
+			maxValue = std::max(maxValue, m_max[level - 1][first >> level]);
+		}
+
+		first += std::size_t(1) << level;
+	}
+}
+
+/*
+	Method which divides the values from first up to, but not including, last into the given number of buckets of equal width and writes the
+	minimum and maximum of each bucket to the output arrays. If there are fewer values than buckets, every value gets its own bucket.
+	Returns the number of buckets written
+*/
+template<class T> std::size_t MinMaxPyramid<T>::query(std::size_t first, std::size_t last, std::size_t buckets, T *minValues, T *maxValues) const {
+	last = std::min(last, m_values.size());
+
+	if (first >= last || buckets == 0) {
+		return 0;
+	}
+
+	std::size_t count = last - first;
+	buckets = std::min(buckets, count);
+
+	for (std::size_t bucket = 0; bucket < buckets; bucket++) {
+		std::size_t bucketFirst = first + bucket * count / buckets;
+		std::size_t bucketLast = first + (bucket + 1) * count / buckets;
+
+		rangeMinMax(bucketFirst, bucketLast, minValues[bucket], maxValues[bucket]);
+	}
+
+	return buckets;
+}
@@ -0,0 +1,165 @@
+#include "PlotDecimator.h"
+#include <cmath>
+
+/*
+	Converts the interleaved data of a trace to a single value per sample point
+*/
+void PlotDecimator::traceValues(const MeasurementTrace &trace, std::vector<double> &values) {
+	int samplePoints = trace.getSamplePoints();
+	values.resize(samplePoints);
+
+	if (trace.format == SMIT) {
+		for (int i = 0; i < samplePoints; i++) {
+			double real = trace.data[2 * i];
+			double imag = trace.data[2 * i + 1];
+
+			values[i] = 10.0 * std::log10(real * real + imag * imag);
+		}
+	}
+	else {
+		for (int i = 0; i < samplePoints; i++) {
+			values[i] = trace.data[2 * i];
+		}
+	}
+}
+
+/*
+	Method which adds a trace. The frequency pyramid of the trace is built before the lock is taken, so the user interface is only held up
+	while the trace is appended to the angle pyramids.
+	A trace with different frequency points to the traces already stored for its parameter replaces them.
+*/
+void PlotDecimator::addTrace(const MeasurementTrace &trace) {
+	std::vector<double> values;
+	traceValues(trace, values);
+
+	MinMaxPyramid<double> frequencyPyramid;
+	frequencyPyramid.assign(values.data(), values.size());
+
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	ParameterPlots &plots = m_plots[trace.parameter];
+
+	if (plots.frequencyPyramids.empty() || plots.samplePoints != trace.getSamplePoints() || plots.startFreq != trace.startFreq || plots.stopFreq != trace.stopFreq) {
+		plots.startFreq = trace.startFreq;
+		plots.stopFreq = trace.stopFreq;
+		plots.samplePoints = trace.getSamplePoints();
+		plots.angles.clear();
+		plots.frequencyPyramids.clear();
+		plots.anglePyramids.assign(plots.samplePoints, MinMaxPyramid<double>());
+	}
+
+	plots.angles.push_back(trace.angle);
+	plots.frequencyPyramids.push_back(std::move(frequencyPyramid));
+
+	for (int i = 0; i < plots.samplePoints; i++) {
+		plots.anglePyramids[i].append(values[i]);
+	}
+}
+
+void PlotDecimator::clear() {
+	boost::mutex::scoped_lock lock(m_mutex);
+	m_plots.clear();
+}
+
+int PlotDecimator::getTraceCount(AnalyserParameter parameter) {
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	auto plots = m_plots.find(parameter);
+	return (plots == m_plots.end()) ? 0 : static_cast<int>(plots->second.angles.size());
+}
+
+bool PlotDecimator::getTraceAngles(AnalyserParameter parameter, std::vector<double> &angles) {
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	auto plots = m_plots.find(parameter);
+
+	if (plots == m_plots.end()) {
+		return false;
+	}
+
+	angles = plots->second.angles;
+	return true;
+}
+
+/*
+	Method which returns the envelope of a trace between two frequencies, divided into the given number of pixels.
+	Returns the number of pixels written, which is smaller than requested when there are fewer sample points than pixels in the range
+*/
+int PlotDecimator::getFrequencyEnvelope(AnalyserParameter parameter, int traceIndex, double startFreq, double stopFreq, int pixels, std::vector<double> &minValues, std::vector<double> &maxValues) {
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	auto found = m_plots.find(parameter);
+
+	if (found == m_plots.end() || traceIndex < 0 || traceIndex >= static_cast<int>(found->second.frequencyPyramids.size()) || pixels <= 0) {
+		return 0;
+	}
+
+	const ParameterPlots &plots = found->second;
+
+	// Work out which sample points fall inside the frequency range
+	int firstPoint = 0;
+	int lastPoint = plots.samplePoints - 1;
+
+	if (plots.stopFreq == plots.startFreq) {
+		// A zero span sweep measures every sample point at the same frequency, so either all of them or none of them are in the range
+		if (startFreq > plots.startFreq || stopFreq < plots.startFreq) {
+			return 0;
+		}
+	}
+	else if (plots.samplePoints > 1) {
+		double freqStep = (plots.stopFreq - plots.startFreq) / (plots.samplePoints - 1);
+
+		// Clamped before the conversion to int, since the frequencies may be far outside the sweep or infinite
+		firstPoint = static_cast<int>(std::min<double>(std::max<double>(firstPoint, std::ceil((startFreq - plots.startFreq) / freqStep - 1e-9)), plots.samplePoints));
+		lastPoint = static_cast<int>(std::max<double>(std::min<double>(lastPoint, std::floor((stopFreq - plots.startFreq) / freqStep + 1e-9)), -1));
+	}
+
+	if (firstPoint > lastPoint) {
+		return 0;
+	}
+
+	minValues.resize(pixels);
+	maxValues.resize(pixels);
+
+	return static_cast<int>(plots.frequencyPyramids[traceIndex].query(firstPoint, lastPoint + 1, pixels, minValues.data(), maxValues.data()));
+}
+
+/*
+	Method which returns the envelope of the value at the sample point closest to a frequency, over the traces from firstTrace up to and including
+	lastTrace, divided into the given number of pixels. A lastTrace of -1 includes all the traces added so far.
+	Returns the number of pixels written
+*/
+int PlotDecimator::getAngleEnvelope(AnalyserParameter parameter, double frequency, int firstTrace, int lastTrace, int pixels, std::vector<double> &minValues, std::vector<double> &maxValues) {
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	auto found = m_plots.find(parameter);
+
+	if (found == m_plots.end() || found->second.angles.empty() || pixels <= 0) {
+		return 0;
+	}
+
+	const ParameterPlots &plots = found->second;
+
+	int point = 0;
+
+	if (plots.samplePoints > 1) {
+		double freqStep = (plots.stopFreq - plots.startFreq) / (plots.samplePoints - 1);
+		point = static_cast<int>(std::lround((frequency - plots.startFreq) / freqStep));
+		point = std::min(std::max(point, 0), plots.samplePoints - 1);
+	}
+
+	int traceCount = static_cast<int>(plots.angles.size());
+
+	if (lastTrace < 0 || lastTrace >= traceCount) {
+		lastTrace = traceCount - 1;
+	}
+
+	if (firstTrace < 0 || firstTrace > lastTrace) {
+		return 0;
+	}
+
+	minValues.resize(pixels);
+	maxValues.resize(pixels);
+
+	return static_cast<int>(plots.anglePyramids[point].query(firstTrace, lastTrace + 1, pixels, minValues.data(), maxValues.data()));
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "MeasurementTrace.h"
+#include "MinMaxPyramid.h"
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <vector>
+
+/*
+	Class which keeps level of detail data of the traces of a measurement, so that a display can draw them at any zoom level without going through
+	every sample. It is meant to be used by a user interface, which can query it from its own thread while the measurement is adding traces.
+	Two kinds of plots are supported for every parameter:
+	- Frequency plots: the envelope of a single trace over a frequency range
+	- Angle plots (e.g. polar plots): the envelope of the value at a single frequency over all the angles measured so far
+	Each trace is converted to a single value per sample point before it is stored. Data in the SMIT format is converted to the magnitude in dB,
+	the other formats are already real valued and their real part is used.
+*/
+class PlotDecimator {
+private:
+	/*
+		The level of detail data of a single parameter
+	*/
+	struct ParameterPlots {
+		double startFreq;
+		double stopFreq;
+		int samplePoints;
+
+		std::vector<double> angles; // The angle of every trace, in the order they were added
+		std::vector<MinMaxPyramid<double>> frequencyPyramids; // A pyramid along frequency for every trace
+		std::vector<MinMaxPyramid<double>> anglePyramids; // A pyramid along angle for every sample point
+	};
+
+	std::map<AnalyserParameter, ParameterPlots> m_plots;
+	boost::mutex m_mutex; // Protects m_plots, since traces are added and queried from different threads
+
+	static void traceValues(const MeasurementTrace &trace, std::vector<double> &values);
+
+public:
+	void addTrace(const MeasurementTrace &trace);
+	void clear();
+
+	int getTraceCount(AnalyserParameter parameter);
+	bool getTraceAngles(AnalyserParameter parameter, std::vector<double> &angles);
+
+	int getFrequencyEnvelope(AnalyserParameter parameter, int traceIndex, double startFreq, double stopFreq, int pixels, std::vector<double> &minValues, std::vector<double> &maxValues);
+	int getAngleEnvelope(AnalyserParameter parameter, double frequency, int firstTrace, int lastTrace, int pixels, std::vector<double> &minValues, std::vector<double> &maxValues);
+};
@@ -27,6 +27,11 @@ public:
 		m_stepAngle = stepAngle;
 	}
 
+	/*
+		Virtual destructor so that derived rotators are cleaned up properly when deleted through a RotatorObj pointer
+	*/
+	virtual ~RotatorObj() {}
+
 	/*
 		Setter Function
 		The setSpeed function is used to be able to modify the value
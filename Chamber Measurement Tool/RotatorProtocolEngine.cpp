@@ -0,0 +1,315 @@
+#include "RotatorProtocolEngine.h"
+#include "SerialRotatorException.h"
+#include <algorithm>
+#include <iostream>
+
+#ifndef _WIN32
+#include <termios.h>
+#endif
+
+/*
+	Constructor of the RotatorProtocolEngine. Opens the serial port and starts the engine thread
+*/
+RotatorProtocolEngine::RotatorProtocolEngine(const std::string &portName, int baudrate, TransportRecorder *recorder)
+	: m_serialConn(m_ioservice), m_timer(m_ioservice), m_discarded(0), m_attempt(0), m_busy(false), m_recorder(recorder), m_commandTimeoutMs(1000), m_moveTimeoutMs(120000), m_retryCount(3) {
+	try {
+		m_serialConn.open(portName);
+
+		m_serialConn.set_option(boost::asio::serial_port_base::baud_rate(baudrate)); // Set the baudrate required for communication
+		m_serialConn.set_option(boost::asio::serial_port_base::character_size(8)); // 8 data bits
+		m_serialConn.set_option(boost::asio::serial_port_base::stop_bits(boost::asio::serial_port_base::stop_bits::one)); // 1 stop bit
+		m_serialConn.set_option(boost::asio::serial_port_base::parity(boost::asio::serial_port_base::parity::none)); // No parity
+	}
+	catch (boost::system::system_error &e) {
+		std::cerr << "There was an error attempting to open the serial port " << portName << std::endl;
+
+		throw(e);
+	}
+
+	m_work.reset(new boost::asio::io_service::work(m_ioservice));
+	m_thread = boost::thread([this]() { m_ioservice.run(); });
+}
+
+/*
+	Sends the speed and acceleration of the rotator. The controller echoes the frame back
+*/
+std::future<void> RotatorProtocolEngine::sendSettings(unsigned char speed, unsigned char accel, Callback callback) {
+	Frame frame = { 1, speed, accel, 3, 4 };
+
+	return submit(frame, std::vector<unsigned char>(frame.begin(), frame.end()), true, m_commandTimeoutMs, m_retryCount, callback);
+}
+
+/*
+	Sends a move command. The steps are sent as a 24 bit big endian number. The controller replies with the command byte
+*/
+std::future<void> RotatorProtocolEngine::move(unsigned char command, unsigned char direction, unsigned long steps, Callback callback) {
+	Frame frame = {
+		command,
+		direction,
+		static_cast<unsigned char>((steps >> 16) & 0xFF),
+		static_cast<unsigned char>((steps >> 8) & 0xFF),
+		static_cast<unsigned char>(steps & 0xFF)
+	};
+
+	return submit(frame, std::vector<unsigned char>(1, command), false, m_moveTimeoutMs, 0, callback);
+}
+
+/*
+	Queues a transaction. The queue is only touched on the engine thread, so the transaction is handed over with post()
+*/
+std::future<void> RotatorProtocolEngine::submit(const Frame &frame, const std::vector<unsigned char> &expected, bool resynchronise, long timeoutMs, int retries, Callback callback) {
+	boost::shared_ptr<Transaction> transaction(new Transaction);
+	transaction->frame = frame;
+	transaction->expected = expected;
+	transaction->resynchronise = resynchronise;
+	transaction->timeoutMs = timeoutMs;
+	transaction->retriesLeft = retries;
+	transaction->callback = callback;
+
+	std::future<void> future = transaction->promise.get_future();
+
+	m_ioservice.post([this, transaction]() {
+		m_queue.push_back(transaction);
+
+		if (!m_busy) {
+			startNext();
+		}
+	});
+
+	return future;
+}
+
+/*
+	Discards everything received from the controller which has not been read yet, so that it cannot be taken as the reply to the next frame
+*/
+void RotatorProtocolEngine::flushInput() {
+	m_received.clear();
+#ifdef _WIN32
+	::PurgeComm(m_serialConn.native_handle(), PURGE_RXCLEAR);
+#else
+	::tcflush(m_serialConn.native_handle(), TCIFLUSH);
+#endif
+}
+
+void RotatorProtocolEngine::startNext() {
+	if (m_queue.empty()) {
+		m_busy = false;
+		return;
+	}
+
+	m_busy = true;
+	startAttempt();
+}
+
+/*
+	Writes the frame of the transaction at the front of the queue and waits for the reply
+*/
+void RotatorProtocolEngine::startAttempt() {
+	unsigned long attempt = ++m_attempt;
+	boost::shared_ptr<Transaction> transaction = m_queue.front();
+
+	flushInput();
+	m_discarded = 0;
+
+	boost::asio::async_write(m_serialConn, boost::asio::buffer(transaction->frame), [this, attempt, transaction](const boost::system::error_code &ec, std::size_t bytes) {
+		if (TransportRecorder *recorder = m_recorder) {
+			recorder->record(ROTATOR_CHANNEL, TO_DEVICE, transaction->frame.data(), bytes);
+		}
+
+		if (attempt != m_attempt) {
+			return;
+		}
+
+		if (ec) {
+			retryOrFail("Unable to write the command to the rotator");
+			return;
+		}
+
+		m_timer.expires_from_now(std::chrono::milliseconds(transaction->timeoutMs));
+		m_timer.async_wait([this, attempt](const boost::system::error_code &ec) { handleTimeout(attempt, ec); });
+
+		startRead(attempt);
+	});
+}
+
+void RotatorProtocolEngine::startRead(unsigned long attempt) {
+	m_serialConn.async_read_some(boost::asio::buffer(m_readBuffer), [this, attempt](const boost::system::error_code &ec, std::size_t bytes) {
+		handleData(attempt, ec, bytes);
+	});
+}
+
+/*
+	Handles data received from the controller. A move only accepts its reply as the first byte received. For other transactions the received bytes
+	are searched for the expected reply, and bytes which cannot be part of it are discarded and reading continues, so that the engine resynchronises
+	on the reply after noise on the line, until the deadline of the attempt
+*/
+void RotatorProtocolEngine::handleData(unsigned long attempt, const boost::system::error_code &ec, std::size_t bytes) {
+	// Everything which arrives is recorded, including bytes which end up being discarded
+	if (TransportRecorder *recorder = m_recorder) {
+		if (!ec) {
+			recorder->record(ROTATOR_CHANNEL, FROM_DEVICE, m_readBuffer.data(), bytes);
+		}
+	}
+
+	if (attempt != m_attempt) {
+		return;
+	}
+
+	if (ec) {
+		if (ec != boost::asio::error::operation_aborted) {
+			retryOrFail("Unable to read the reply of the rotator");
+		}
+		return;
+	}
+
+	const Transaction &transaction = *m_queue.front();
+	const std::vector<unsigned char> &expected = transaction.expected;
+	m_received.insert(m_received.end(), m_readBuffer.begin(), m_readBuffer.begin() + bytes);
+
+	if (!transaction.resynchronise) {
+		if (m_received.size() < expected.size()) {
+			startRead(attempt);
+		}
+		else if (std::equal(expected.begin(), expected.end(), m_received.begin())) {
+			finish(nullptr);
+		}
+		else {
+			retryOrFail("Received an invalid reply from the rotator");
+		}
+		return;
+	}
+
+	auto match = std::search(m_received.begin(), m_received.end(), expected.begin(), expected.end());
+
+	if (match != m_received.end()) {
+		finish(nullptr);
+		return;
+	}
+
+	// Keep only the longest tail of the received bytes which could still be the start of the expected reply
+	std::size_t keep = std::min(m_received.size(), expected.size() - 1);
+
+	while (keep > 0 && !std::equal(m_received.end() - keep, m_received.end(), expected.begin())) {
+		keep--;
+	}
+
+	m_discarded += m_received.size() - keep;
+	m_received.erase(m_received.begin(), m_received.end() - keep);
+
+	startRead(attempt);
+}
+
+void RotatorProtocolEngine::handleTimeout(unsigned long attempt, const boost::system::error_code &ec) {
+	if (attempt != m_attempt || ec == boost::asio::error::operation_aborted) {
+		return;
+	}
+
+	retryOrFail((m_discarded > 0) ? "Received an invalid reply from the rotator" : "The rotator did not reply in time");
+}
+
+/*
+	Sends the frame of the current transaction again if it has any retries left, otherwise fails it
+*/
+void RotatorProtocolEngine::retryOrFail(const char *reason) {
+	boost::system::error_code ignored;
+	m_serialConn.cancel(ignored);
+	m_timer.cancel(ignored);
+
+	// A late reply to the failed attempt must not be taken as the reply to the next one
+	flushInput();
+
+	boost::shared_ptr<Transaction> transaction = m_queue.front();
+
+	if (transaction->retriesLeft > 0) {
+		transaction->retriesLeft--;
+		std::cerr << reason << ". Retrying" << std::endl;
+		startAttempt();
+	}
+	else {
+		finish(reason);
+	}
+}
+
+/*
+	Completes the current transaction and starts the next one. A nullptr error means that the transaction succeeded
+*/
+void RotatorProtocolEngine::finish(const char *error) {
+	boost::system::error_code ignored;
+	m_timer.cancel(ignored);
+
+	// Handlers of this attempt which are still pending must be ignored
+	++m_attempt;
+
+	boost::shared_ptr<Transaction> transaction = m_queue.front();
+	m_queue.pop_front();
+
+	if (error) {
+		// Stop reading, the next transaction starts a new read
+		m_serialConn.cancel(ignored);
+	}
+
+	// The callback is called first, so that whatever it updates is visible to the thread waiting on the future
+	if (transaction->callback) {
+		transaction->callback(error == nullptr);
+	}
+
+	if (error) {
+		transaction->promise.set_exception(std::make_exception_ptr(SerialRotatorException(error)));
+	}
+	else {
+		transaction->promise.set_value();
+	}
+
+	startNext();
+}
+
+/*
+	Setter and getter methods. Changes apply to transactions submitted afterwards
+*/
+
+void RotatorProtocolEngine::setCommandTimeout(long milliseconds) {
+	m_commandTimeoutMs = std::max(milliseconds, 1L);
+}
+
+void RotatorProtocolEngine::setMoveTimeout(long milliseconds) {
+	m_moveTimeoutMs = std::max(milliseconds, 1L);
+}
+
+void RotatorProtocolEngine::setRetryCount(int retryCount) {
+	m_retryCount = std::max(retryCount, 0);
+}
+
+/*
+	Sets the recorder which is given every byte sent to and received from the controller. Passing a nullptr stops the recording.
+	The recorder is not owned by the engine and must outlive it, or be removed first.
+*/
+void RotatorProtocolEngine::setRecorder(TransportRecorder *recorder) {
+	m_recorder = recorder;
+}
+
+long RotatorProtocolEngine::getCommandTimeout() {
+	return m_commandTimeoutMs;
+}
+
+long RotatorProtocolEngine::getMoveTimeout() {
+	return m_moveTimeoutMs;
+}
+
+int RotatorProtocolEngine::getRetryCount() {
+	return m_retryCount;
+}
+
+/*
+	Destructor of the RotatorProtocolEngine. Closes the serial port and stops the engine thread. Transactions which have not completed are abandoned,
+	which makes their futures report a broken promise
+*/
+RotatorProtocolEngine::~RotatorProtocolEngine() {
+	m_ioservice.post([this]() {
+		boost::system::error_code ignored;
+		m_timer.cancel(ignored);
+		m_serialConn.close(ignored);
+	});
+
+	m_work.reset();
+	m_thread.join();
+}
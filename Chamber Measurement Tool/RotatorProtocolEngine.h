@@ -0,0 +1,92 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <boost/asio/serial_port.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include "TransportCapture.h"
+#include <atomic>
+#include <array>
+#include <deque>
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+/*
+	Engine which handles the 5 byte serial protocol of the rotator controller on its own thread.
+	Every command is a transaction: the 5 byte frame is written and the reply is read asynchronously with a deadline.
+	- Settings frames (speed and acceleration) are echoed back by the controller. A missing or wrong echo causes the frame to be sent again.
+	- Move frames are answered with a single byte equal to the command byte once the move has been accepted or completed. Moves are never sent
+	  twice, since that could rotate the antenna twice as far, so a move which misses its deadline fails. Since that byte can also appear inside
+	  other data, only the first byte received after the frame is taken as the reply, and a move whose first byte is wrong fails.
+	Unread input, e.g. a late reply to a frame which missed its deadline, is flushed before every attempt and after every failure. Bytes received
+	before the echo of a settings frame, e.g. line noise, are discarded so that the stream resynchronises on the echo.
+	Transactions are queued and run one at a time. Their outcome is reported through a future and, optionally, a callback which is called on the
+	engine thread just before the future becomes ready. A failed transaction sets a SerialRotatorException on the future.
+*/
+class RotatorProtocolEngine {
+public:
+	typedef std::array<unsigned char, 5> Frame;
+	typedef std::function<void(bool success)> Callback;
+
+private:
+	/*
+		A single command sent to the controller, together with the reply it expects
+	*/
+	struct Transaction {
+		Frame frame;
+		std::vector<unsigned char> expected; // The reply which completes the transaction
+		bool resynchronise; // Whether bytes received before the expected reply may be discarded. Otherwise the reply must be the first data received
+		long timeoutMs; // Deadline for the reply after each attempt
+		int retriesLeft; // Number of times the frame may still be sent again
+		std::promise<void> promise;
+		Callback callback;
+	};
+
+	boost::asio::io_service m_ioservice;
+	boost::scoped_ptr<boost::asio::io_service::work> m_work;
+	boost::asio::serial_port m_serialConn;
+	boost::asio::steady_timer m_timer;
+	boost::thread m_thread;
+
+	std::deque<boost::shared_ptr<Transaction>> m_queue; // Transactions waiting to be run. The front is the one in progress. Only used on the engine thread
+	std::vector<unsigned char> m_received; // Bytes received for the transaction in progress
+	std::array<unsigned char, 64> m_readBuffer;
+	std::size_t m_discarded; // Number of bytes discarded during the current attempt
+	unsigned long m_attempt; // Incremented with every attempt so that handlers of earlier attempts can be ignored
+	bool m_busy;
+	std::atomic<TransportRecorder *> m_recorder; // Optional recorder of every byte exchanged with the controller. Not owned by the engine
+
+	long m_commandTimeoutMs;
+	long m_moveTimeoutMs;
+	int m_retryCount;
+
+	std::future<void> submit(const Frame &frame, const std::vector<unsigned char> &expected, bool resynchronise, long timeoutMs, int retries, Callback callback);
+	void flushInput();
+	void startNext();
+	void startAttempt();
+	void startRead(unsigned long attempt);
+	void handleData(unsigned long attempt, const boost::system::error_code &ec, std::size_t bytes);
+	void handleTimeout(unsigned long attempt, const boost::system::error_code &ec);
+	void retryOrFail(const char *reason);
+	void finish(const char *error);
+
+public:
+	RotatorProtocolEngine(const std::string &portName, int baudrate = 9600, TransportRecorder *recorder = nullptr);
+
+	std::future<void> sendSettings(unsigned char speed, unsigned char accel, Callback callback = Callback());
+	std::future<void> move(unsigned char command, unsigned char direction, unsigned long steps, Callback callback = Callback());
+
+	void setCommandTimeout(long milliseconds);
+	void setMoveTimeout(long milliseconds);
+	void setRetryCount(int retryCount);
+	void setRecorder(TransportRecorder *recorder);
+
+	long getCommandTimeout();
+	long getMoveTimeout();
+	int getRetryCount();
+
+	~RotatorProtocolEngine();
+};
@@ -1,10 +1,6 @@
 #include "SerialRotatorObj.h"
 #include "SerialRotatorException.h"
-#include <boost\format.hpp>
-#include <boost\optional.hpp>
-#include <boost\timer.hpp>
-#include <boost\chrono.hpp>
-#include <boost\bind.hpp>
+#include <boost/format.hpp>
 #include <iostream>
 #include <cmath>
 #include <array>
@@ -24,162 +20,156 @@ template<typename T> int sgn(T val) {
 	This initialises the SerialRotatorObj with the supplied initial parameters.
 	Some of the input parameters of function have default values assigned to them. Refer back to SerialObj.h for the class declaration and the defualt parameters
 */
-SerialRotatorObj::SerialRotatorObj(unsigned char speed, unsigned char accel, double stepAngle, unsigned char COMPort, int baudrate)  : RotatorObj(speed, accel, stepAngle){
+SerialRotatorObj::SerialRotatorObj(unsigned char speed, unsigned char accel, double stepAngle, unsigned char COMPort, int baudrate, TransportRecorder *recorder)  : RotatorObj(speed, accel, stepAngle){
 	this->m_COMPort = COMPort;
 	this->baudrate = baudrate;
 	this->m_currentPosition = 0.0;
+	this->m_commandedPosition = 0.0;
 
-	m_serialConn.reset(new boost::asio::serial_port(m_ios)); // This initialises the Serial Object with the ios object
-
-	try {
-		boost::system::error_code ec;
-
-		m_serialConn->open(boost::str(boost::format("COM%d") % this->m_COMPort)); // open serial port with parameter COM[COMPort]. Format function is used to convert COMPort number to string
-
-		m_serialConn->set_option(boost::asio::serial_port_base::baud_rate(this->baudrate)); // Set the baudrate required for communication
-		m_serialConn->set_option(boost::asio::serial_port_base::character_size(8)); // set the character length of serial communications. This is 8 bits by default as opposed to 9 bits
-		m_serialConn->set_option(boost::asio::serial_port_base::stop_bits(boost::asio::serial_port_base::stop_bits::one)); // set the number of stop bits. This is set to 1 by default
-		m_serialConn->set_option(boost::asio::serial_port_base::parity(boost::asio::serial_port_base::parity::none)); // set the number of parity bits. This is set to none by default
-
-		std::array<unsigned char, 5> command = { 1, this->m_speed, this->m_accel, 3, 4 }; // create integer array which holds the commands which will be sent to the rotator for initialisation
-
-		boost::asio::write(*m_serialConn, boost::asio::buffer(command, 5)); // Write the initialisation command to the rotator
+	connect(boost::str(boost::format("COM%d") % this->m_COMPort), recorder); // open serial port with parameter COM[COMPort]. Format function is used to convert COMPort number to string
+}
 
-		std::array<unsigned char, 5> reply; // create a character array which waits for the response from the rotator
+/*
+	Constructor of SerialRotatorObj which opens the serial port by name, e.g. /dev/ttyUSB0 on Linux
+*/
+SerialRotatorObj::SerialRotatorObj(unsigned char speed, unsigned char accel, double stepAngle, const std::string &portName, int baudrate, TransportRecorder *recorder) : RotatorObj(speed, accel, stepAngle) {
+	this->m_COMPort = -1;
+	this->baudrate = baudrate;
+	this->m_currentPosition = 0.0;
+	this->m_commandedPosition = 0.0;
 
-		boost::asio::read(*m_serialConn, boost::asio::buffer(reply, 5), boost::asio::transfer_all()); // transfer the data in the serial buffer to the reply array
+	connect(portName, recorder);
+}
 
-		/*
-			If the rotator does not return the sent command to the user, then an exception needs to be thrown
-		*/
-		if (!std::equal(command.begin(), command.end(), reply.begin())) {
-			throw SerialRotatorException("Unable to change rotator speed. Did not receive the correct reply from the rotator");
-		}
+/*
+	Opens the serial port and sends the initialisation command to the rotator. The recorder, if any, is given every byte from the start
+*/
+void SerialRotatorObj::connect(const std::string &portName, TransportRecorder *recorder) {
+	try {
+		m_engine.reset(new RotatorProtocolEngine(portName, this->baudrate, recorder));
 	}
 	catch (boost::system::system_error &e) {
 		std::cerr << "There was an error attempting to connect to the rotator" << std::endl;
 
 		throw(e);
 	}
+
+	sendSettings();
 }
 
 /*
-	THis function is used to send a command to the rotator to rotate the rotator by some angle.
+	Sends the speed and acceleration to the rotator and waits for the rotator to confirm them.
+	If the rotator does not return the sent command, the engine retries and eventually throws a SerialRotatorException
 */
-void SerialRotatorObj::rotateBy(RotatorDirection direction, double angle, bool wait) {
-	// Check whether the input angle is greater than the minimum resolution of the rotator
-	if (std::abs(angle) > 0.01) {
+void SerialRotatorObj::sendSettings() {
+	m_engine->sendSettings(this->m_speed, this->m_accel).get();
+}
 
-		this->m_currentPosition += direction * angle; // update the current position of the rotator for client tracking purposes
+/*
+	Sends the move command which rotates the rotator by some angle, or to some position if relative is false. The move is worked out from the position
+	commanded by the moves submitted so far, so moves may be queued before the earlier ones have completed.
+	The number of steps is sent to the controller as a 24 bit number, 2e5 steps make up a full rotation.
+*/
+std::future<void> SerialRotatorObj::startMove(double angle, bool relative, unsigned char command, RotatorProtocolEngine::Callback callback) {
+	boost::mutex::scoped_lock lock(m_positionMutex);
 
-		int rotationSteps = static_cast<int>(std::round(angle * 2e5 / 360.0)); // calculate the number of rotation steps needed to be taken by the rotator controller
-		std::array<unsigned char, 3> cAngle;
+	double change = relative ? angle : angle - m_commandedPosition;
 
-		/*
-			Calculation of the values which form part of the command which will be sent to the rotator
-		*/
-		cAngle[0] = static_cast<unsigned char>(std::floor(rotationSteps / std::powf(2.0, 16)));
-		cAngle[1] = static_cast<unsigned char>(std::floor((rotationSteps - cAngle[0] * std::powf(2.0, 16)) / std::powf(2.0, 8)));
-		cAngle[2] = static_cast<unsigned char>(std::round(std::fmod(rotationSteps, std::powf(2.0, 8))));
+	// Check whether the angle is greater than the minimum resolution of the rotator
+	if (std::abs(change) <= 0.01) {
+		lock.unlock();
 
-		unsigned char moveCommand[5];
+		std::promise<void> done;
+		done.set_value();
 
-		// The values are assigned to the move command which will be sent.
+		if (callback) {
+			callback(true);
+		}
 
-		moveCommand[1] = direction;
-		moveCommand[2] = cAngle[0];
-		moveCommand[3] = cAngle[1];
-		moveCommand[4] = cAngle[2];
+		return done.get_future();
+	}
 
-		// The first value of the move command changes according to whether one waits for the rotator to finish or whether one is going to send commands before the analyser finishes moving.
+	RotatorDirection direction = static_cast<RotatorDirection>(sgn(change));
+	unsigned long rotationSteps = static_cast<unsigned long>(std::lround(std::abs(change) * 2e5 / 360.0)); // calculate the number of rotation steps needed to be taken by the rotator controller
 
-		if (wait) {
-			moveCommand[0] = 3;
-		}
-		else {
-			moveCommand[0] = 2;
-		}
+	m_commandedPosition += change;
 
-		// The try block where the data will be transmitted to the rotator
-		try {
-			unsigned char reply = 0;
-			boost::system::error_code ec;
-			
-			boost::asio::write(*m_serialConn, boost::asio::buffer(moveCommand, 5)); // send command to rotator
-
-			/*
-				Wait for the rotator to reply
-			*/
-			while ((reply != 2) || (reply != 3)) {
-				boost::asio::read(*m_serialConn, boost::asio::buffer(&reply, 1));
+	// The position used for client tracking is only updated once the controller has confirmed the move. A failed move takes its change back off
+	// the commanded position, so the moves queued after it still end where they would have. The engine calls the callback before the future
+	// becomes ready, so the position is up to date for whoever waits on the future
+	return m_engine->move(command, static_cast<unsigned char>(direction), rotationSteps, [this, change, callback](bool success) {
+		{
+			boost::mutex::scoped_lock lock(m_positionMutex);
+
+			if (success) {
+				this->m_currentPosition += change;
+			}
+			else {
+				m_commandedPosition -= change;
 			}
 		}
-		catch (boost::system::system_error &e) {
-			std::cerr << "There was a problem attempting to rotate to the requested position" << std::endl;
-			throw(e);
+
+		if (callback) {
+			callback(success);
 		}
-	}
+	});
 }
 
+/*
+	This function is used to send a command to the rotator to rotate the rotator by some angle, and waits for the rotator to reply.
+	The first value of the move command changes according to whether one waits for the rotator to finish (3) or whether the rotator replies straight away (2).
+*/
+void SerialRotatorObj::rotateBy(RotatorDirection direction, double angle, bool wait) {
+	try {
+		startMove(direction * angle, true, wait ? 3 : 2, RotatorProtocolEngine::Callback()).get();
+	}
+	catch (SerialRotatorException &e) {
+		std::cerr << "There was a problem attempting to rotate to the requested position" << std::endl;
+		throw(e);
+	}
+}
 
 /*
 	Rotate to a specific angle
 */
 void SerialRotatorObj::rotateTo(double position, bool wait) {
-	double rotateAngle = position - this->m_currentPosition;
+	try {
+		startMove(position, false, wait ? 3 : 2, RotatorProtocolEngine::Callback()).get();
+	}
+	catch (SerialRotatorException &e) {
+		std::cerr << "There was a problem attempting to rotate to the requested position" << std::endl;
+		throw(e);
+	}
+}
+
+/*
+	Starts rotating the rotator by some angle and returns straight away. The future becomes ready, and the callback is called, once the rotator
+	has finished moving. A failed move sets a SerialRotatorException on the future.
+*/
+std::future<void> SerialRotatorObj::rotateByAsync(RotatorDirection direction, double angle, RotatorProtocolEngine::Callback callback) {
+	return startMove(direction * angle, true, 3, callback);
+}
 
-	rotateBy(static_cast<RotatorDirection>(sgn(rotateAngle)), rotateAngle, wait);
+std::future<void> SerialRotatorObj::rotateToAsync(double position, RotatorProtocolEngine::Callback callback) {
+	return startMove(position, false, 3, callback);
 }
 
 /*
 	Overridden function for setSpeed to set the internal variable and send a command to change the rotation speed
 */
 void SerialRotatorObj::setSpeed(unsigned char speed) {
-	this->setSpeed(speed); // set internal value of internal variable
-
-	std::array<unsigned char, 5> command = { 1, this->m_speed, this->m_accel, 3, 4 };  // create the command to be sent to the rotator
-
-	// try to send the command
-	try {
-		boost::asio::write(*m_serialConn, boost::asio::buffer(command, 5));
-
-		std::array<unsigned char, 5> reply;
+	RotatorObj::setSpeed(speed); // set internal value of internal variable
 
-		boost::asio::read(*m_serialConn, boost::asio::buffer(reply, 5));
-
-		if (!std::equal(command.begin(), command.end(), reply.begin())) {
-			throw SerialRotatorException("Unable to change rotator speed. Did not receive the correct reply from the rotator");
-		}
-	}
-	catch (boost::system::system_error &e) {
-		std::cerr << "There was an issue whilst attempting to set the rotator speed" << std::endl;
-		throw(e);
-	}
+	sendSettings();
 }
 
 /*
 	Overridden function for setAccel to set the internal variable and send the command to change the acceleration
 */
 void SerialRotatorObj::setAccel(unsigned char accel) {
-	this->setAccel(accel);
-
-	std::array<unsigned char, 5> command = { 1, this->m_speed, this->m_accel, 3, 4 };
-
-	try {
-		boost::asio::write(*m_serialConn, boost::asio::buffer(command, 5));
+	RotatorObj::setAccel(accel);
 
-		std::array<unsigned char, 5> reply;
-
-		boost::asio::read(*m_serialConn, boost::asio::buffer(reply, 5));
-
-		if (!std::equal(command.begin(), command.end(), reply.begin())) {
-			throw SerialRotatorException("Unable to change rotator speed. Did not receive the correct reply from the rotator");
-		}
-	}
-	catch (boost::system::system_error &e) {
-		std::cerr << "There was an issues whilst attempting to set the rotator acceleration" << std::endl;
-		throw(e);
-	}
+	sendSettings();
 }
 
 void SerialRotatorObj::setStepAngle(double stepAngle) {
@@ -187,7 +177,10 @@ void SerialRotatorObj::setStepAngle(double stepAngle) {
 }
 
 void SerialRotatorObj::setCurrentPosition(double currentPosition) {
+	boost::mutex::scoped_lock lock(m_positionMutex);
+
 	this->m_currentPosition = currentPosition;
+	this->m_commandedPosition = currentPosition;
 }
 
 unsigned char SerialRotatorObj::getSpeed() {
@@ -203,12 +196,15 @@ double SerialRotatorObj::getStepAngle() {
 }
 
 double SerialRotatorObj::getCurrentPosition() {
+	boost::mutex::scoped_lock lock(m_positionMutex);
+
 	return m_currentPosition;
 }
 
-// Destructor function for SerialRotatorObj. This function will close the serial comm object once this object is destroyed
+RotatorProtocolEngine &SerialRotatorObj::getProtocolEngine() {
+	return *m_engine;
+}
+
+// Destructor function for SerialRotatorObj. The serial port is closed by the protocol engine once this object is destroyed
 SerialRotatorObj::~SerialRotatorObj() {
-	if (m_serialConn->is_open()) {
-		m_serialConn->close();
-	}
 }
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 #include "RotatorObj.h"
-#include <boost\scoped_ptr.hpp>
-#include <boost\asio.hpp>
-#include <boost\asio\serial_port.hpp>
+#include "RotatorProtocolEngine.h"
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <future>
+#include <string>
 
 /*
 	Enumeration object used to determine the rotation direction of the rotator
@@ -15,20 +17,33 @@ enum RotatorDirection {
 };
 
 /*
-	Create serialRotatorObj which is derived from a RotatorObj, but the connection is specialised for Serial communications
+	Create serialRotatorObj which is derived from a RotatorObj, but the connection is specialised for Serial communications.
+	The communication itself is handled by a RotatorProtocolEngine on its own thread. The blocking methods wait for the engine to finish,
+	the Async methods return straight away so that the calling thread is free while the rotator moves.
 */
 class SerialRotatorObj : public RotatorObj {
 private:
 	int m_COMPort; // The serial COM port over which communication which will take place between the computer and the rotator
 	int baudrate; // The agreed upon data rate between the computer and the serial rotator
 	 
-	boost::asio::io_service m_ios; // This is the worker class for Boost's IO communications library. This is needed to perform the necessary communication functions
-	boost::scoped_ptr<boost::asio::serial_port> m_serialConn; // This creates a serial communications object
+	boost::scoped_ptr<RotatorProtocolEngine> m_engine; // Handles the communication with the rotator controller
+
+	// m_currentPosition only changes once the controller has confirmed a move, on the engine thread. m_commandedPosition is where the rotator
+	// will be once all the submitted moves have completed, and is what new moves are computed from. Both are guarded by m_positionMutex
+	double m_commandedPosition;
+	boost::mutex m_positionMutex;
+
+	void connect(const std::string &portName, TransportRecorder *recorder);
+	void sendSettings();
+	std::future<void> startMove(double angle, bool relative, unsigned char command, RotatorProtocolEngine::Callback callback);
 
 public:
-	SerialRotatorObj(unsigned char speed = 1, unsigned char accel = 255, double stepAngle = 5, unsigned char COMPort = 4, int baudrate = 9600);
+	SerialRotatorObj(unsigned char speed = 1, unsigned char accel = 255, double stepAngle = 5, unsigned char COMPort = 4, int baudrate = 9600, TransportRecorder *recorder = nullptr);
+	SerialRotatorObj(unsigned char speed, unsigned char accel, double stepAngle, const std::string &portName, int baudrate = 9600, TransportRecorder *recorder = nullptr);
 	void rotateBy(RotatorDirection direction, double angle, bool wait = 1);
 	void rotateTo(double position, bool wait = 1);
+	std::future<void> rotateByAsync(RotatorDirection direction, double angle, RotatorProtocolEngine::Callback callback = RotatorProtocolEngine::Callback());
+	std::future<void> rotateToAsync(double position, RotatorProtocolEngine::Callback callback = RotatorProtocolEngine::Callback());
 	void setSpeed(unsigned char speed = 255);
 	void setAccel(unsigned char accel = 1);
 	void setStepAngle(double stepAngle = 5.0);
@@ -38,6 +53,7 @@ public:
 	unsigned char getAccel();
 	double getStepAngle();
 	double getCurrentPosition();
+	RotatorProtocolEngine &getProtocolEngine();
 
 	~SerialRotatorObj();
-};
\ No newline at end of file
+};
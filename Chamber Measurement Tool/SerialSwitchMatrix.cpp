@@ -0,0 +1,176 @@
+#include "SerialSwitchMatrix.h"
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/format.hpp>
+#include <iostream>
+
+#ifndef _WIN32
+#include <termios.h>
+#endif
+
+/*
+	Constructor of the SerialSwitchMatrix. Opens the serial port and starts the thread which talks to the controller.
+	The path of the switch is not known until the first path has been selected
+*/
+SerialSwitchMatrix::SerialSwitchMatrix(const std::string &portName, int baudrate, long settleMicroseconds)
+	: m_serialConn(m_ioservice), m_timer(m_ioservice), m_path(-1), m_settleMicroseconds(settleMicroseconds), m_commandTimeoutMs(1000) {
+	try {
+		m_serialConn.open(portName);
+
+		m_serialConn.set_option(boost::asio::serial_port_base::baud_rate(baudrate));
+		m_serialConn.set_option(boost::asio::serial_port_base::character_size(8));
+		m_serialConn.set_option(boost::asio::serial_port_base::stop_bits(boost::asio::serial_port_base::stop_bits::one));
+		m_serialConn.set_option(boost::asio::serial_port_base::parity(boost::asio::serial_port_base::parity::none));
+	}
+	catch (boost::system::system_error &e) {
+		std::cerr << "There was an error attempting to open the serial port " << portName << " of the switch matrix" << std::endl;
+
+		throw(e);
+	}
+
+	m_work.reset(new boost::asio::io_service::work(m_ioservice));
+	m_thread = boost::thread([this]() { m_ioservice.run(); });
+}
+
+/*
+	Starts selecting a path and returns straight away. The future becomes ready once the path has settled and can be measured, and holds a
+	boost::system::system_error if the controller did not confirm the path. Waits for the previous selection to finish first, and returns a
+	future which is already ready if the path is already selected.
+*/
+std::shared_future<void> SerialSwitchMatrix::selectPathAsync(int path) {
+	if (m_lastSelection.valid()) {
+		m_lastSelection.wait();
+	}
+
+	boost::shared_ptr<std::promise<void>> promise(new std::promise<void>);
+	m_lastSelection = promise->get_future().share();
+
+	if (path == m_path) {
+		promise->set_value();
+		return m_lastSelection;
+	}
+
+	m_path = path;
+	m_command = boost::str(boost::format(":ROUT:CLOS (@%d);*OPC?\n") % path);
+
+	m_ioservice.post([this, promise]() {
+		flushInput();
+
+		boost::asio::async_write(m_serialConn, boost::asio::buffer(m_command), [this, promise](const boost::system::error_code &ec, std::size_t) {
+			if (ec) {
+				fail(promise, ec, "Unable to write the command to the switch matrix");
+				return;
+			}
+
+			// The read is cancelled if the controller does not answer before the deadline
+			m_timer.expires_from_now(std::chrono::milliseconds(m_commandTimeoutMs));
+			m_timer.async_wait([this](const boost::system::error_code &ec) {
+				if (!ec) {
+					boost::system::error_code ignored;
+					m_serialConn.cancel(ignored);
+				}
+			});
+
+			boost::asio::async_read_until(m_serialConn, m_replyBuffer, '\n', [this, promise](const boost::system::error_code &ec, std::size_t bytes) {
+				handleReply(promise, ec, bytes);
+			});
+		});
+	});
+
+	return m_lastSelection;
+}
+
+/*
+	Selects a path and waits until it has settled. Throws a boost::system::system_error if the controller did not confirm the path
+*/
+void SerialSwitchMatrix::selectPath(int path) {
+	selectPathAsync(path).get();
+}
+
+/*
+	Checks the answer to *OPC? and waits for the relays to settle
+*/
+void SerialSwitchMatrix::handleReply(boost::shared_ptr<std::promise<void>> promise, const boost::system::error_code &ec, std::size_t bytes) {
+	boost::system::error_code ignored;
+	m_timer.cancel(ignored);
+
+	if (ec == boost::asio::error::operation_aborted) {
+		fail(promise, boost::asio::error::timed_out, "The switch matrix did not answer in time");
+		return;
+	}
+
+	if (ec) {
+		fail(promise, ec, "Unable to read the answer of the switch matrix");
+		return;
+	}
+
+	std::string reply(boost::asio::buffer_cast<const char *>(m_replyBuffer.data()), bytes);
+	m_replyBuffer.consume(bytes);
+	boost::algorithm::trim(reply);
+
+	if (reply != "1") {
+		fail(promise, boost::asio::error::invalid_argument, "Received an invalid answer from the switch matrix");
+		return;
+	}
+
+	m_timer.expires_from_now(std::chrono::microseconds(m_settleMicroseconds));
+	m_timer.async_wait([promise](const boost::system::error_code &) {
+		promise->set_value();
+	});
+}
+
+/*
+	Fails the selection. The path of the switch is no longer known, so it is selected again the next time it is needed
+*/
+void SerialSwitchMatrix::fail(boost::shared_ptr<std::promise<void>> promise, const boost::system::error_code &ec, const char *reason) {
+	m_path = -1;
+	flushInput();
+
+	std::cerr << reason << std::endl;
+	promise->set_exception(std::make_exception_ptr(boost::system::system_error(ec, reason)));
+}
+
+/*
+	Discards the bytes which have been received but not read, both in the reply buffer and in the input buffer of the serial port.
+	Runs on the thread of the switch matrix
+*/
+void SerialSwitchMatrix::flushInput() {
+	m_replyBuffer.consume(m_replyBuffer.size());
+
+#ifdef _WIN32
+	::PurgeComm(m_serialConn.native_handle(), PURGE_RXCLEAR);
+#else
+	::tcflush(m_serialConn.native_handle(), TCIFLUSH);
+#endif
+}
+
+void SerialSwitchMatrix::setSettleTime(long microseconds) {
+	m_settleMicroseconds = microseconds;
+}
+
+void SerialSwitchMatrix::setCommandTimeout(long milliseconds) {
+	m_commandTimeoutMs = milliseconds;
+}
+
+int SerialSwitchMatrix::getPath() {
+	return m_path;
+}
+
+long SerialSwitchMatrix::getSettleTime() {
+	return m_settleMicroseconds;
+}
+
+long SerialSwitchMatrix::getCommandTimeout() {
+	return m_commandTimeoutMs;
+}
+
+// The serial port is closed on the thread which uses it, any selection in progress is abandoned
+SerialSwitchMatrix::~SerialSwitchMatrix() {
+	m_ioservice.post([this]() {
+		boost::system::error_code ignored;
+		m_timer.cancel(ignored);
+		m_serialConn.close(ignored);
+	});
+
+	m_work.reset();
+	m_thread.join();
+}
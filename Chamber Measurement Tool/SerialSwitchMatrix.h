@@ -0,0 +1,71 @@
+#pragma once
+#include "AnalyserObj.h"
+#include <boost/asio.hpp>
+#include <boost/asio/serial_port.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <atomic>
+#include <future>
+#include <string>
+
+/*
+	How a parameter of a measurement is obtained through the switch matrix: the path which is selected and the parameter which the analyser
+	measures on that path. E.g. the co-polar and cross-polar ports of the probe can both be routed to port 2 of the analyser, and be stored as
+	S21 and S31 so that they can be told apart.
+*/
+struct SwitchRoute {
+	int path; // Path of the switch matrix
+	AnalyserParameter measured; // Parameter which the analyser measures while the path is selected
+};
+
+/*
+	RF switch matrix controlled over a serial link, used to route the receive antennas to the analyser one after the other.
+	A path is selected with the SCPI command ":ROUT:CLOS (@<path>)" followed by *OPC?, which the controller answers with 1 once the relays have
+	been switched. The path is only used once the settle time has passed after the answer, so that the relays have stopped bouncing.
+	The communication runs on its own thread: selectPathAsync() returns straight away, so the calling thread can transfer data from the analyser
+	while the switch settles. Unread input is discarded before every command and after a failure, so that the late answer to a selection which
+	timed out is not taken as the answer to the next one.
+*/
+class SerialSwitchMatrix {
+private:
+	boost::asio::io_service m_ioservice;
+	boost::scoped_ptr<boost::asio::io_service::work> m_work;
+	boost::asio::serial_port m_serialConn;
+	boost::asio::steady_timer m_timer; // Deadline of the answer, then the settle time
+	boost::thread m_thread;
+
+	boost::asio::streambuf m_replyBuffer;
+	std::string m_command; // The command being sent, kept alive until it has been written
+	std::shared_future<void> m_lastSelection; // Completes once the last selected path can be used
+
+	std::atomic<int> m_path; // Path which was selected last, -1 if it is not known
+	long m_settleMicroseconds; // Time the relays need to settle after the controller has answered
+	long m_commandTimeoutMs; // Deadline for the answer of the controller
+
+	void handleReply(boost::shared_ptr<std::promise<void>> promise, const boost::system::error_code &ec, std::size_t bytes);
+	void fail(boost::shared_ptr<std::promise<void>> promise, const boost::system::error_code &ec, const char *reason);
+	void flushInput();
+
+public:
+	SerialSwitchMatrix(const std::string &portName, int baudrate = 9600, long settleMicroseconds = 20000);
+
+	std::shared_future<void> selectPathAsync(int path);
+	void selectPath(int path);
+
+	/*
+		Setter methods
+	*/
+	void setSettleTime(long microseconds);
+	void setCommandTimeout(long milliseconds);
+
+	/*
+		Getter methods
+	*/
+	int getPath();
+	long getSettleTime();
+	long getCommandTimeout();
+
+	~SerialSwitchMatrix();
+};
@@ -0,0 +1,293 @@
+#include "SweepAutoTuner.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+// The IFBWs which are considered, from the narrowest to the widest
+static const double CANDIDATE_IFBWS[] = { 10, 30, 100, 300, 1e3, 3e3, 10e3, 30e3, 100e3, 300e3 };
+static const int CANDIDATE_IFBW_COUNT = sizeof(CANDIDATE_IFBWS) / sizeof(CANDIDATE_IFBWS[0]);
+
+TuningTarget::TuningTarget() {
+	dynamicRange = 60;
+	uncertainty = 0.1;
+	uncertaintyRange = 20;
+	interpolationError = 0.2;
+	preservePhase = false;
+}
+
+SweepAutoTuner::SweepAutoTuner(const TuningTarget &target) {
+	m_target = target;
+	m_calibrationSweeps = 4;
+	m_calibrationPoints = 1601;
+	m_calibrationIFBW = 10e3;
+	m_measureNoiseFloor = true;
+}
+
+/*
+	Method which tunes each of the bands in turn. Returns false if the calibration sweeps of any band could not be captured
+*/
+bool SweepAutoTuner::tune(AnalyserObj<double> &analyser, const std::vector<FrequencyBand> &bands, std::vector<TuningResult> &results) {
+	results.clear();
+
+	for (const FrequencyBand &band : bands) {
+		TuningResult result;
+
+		if (!tuneBand(analyser, band, result)) {
+			return false;
+		}
+
+		results.push_back(result);
+	}
+
+	return true;
+}
+
+/*
+	Method which takes the calibration sweeps of a band and chooses its settings. The data is captured in the SMIT format so that the complex
+	values are available. The settings of the analyser are restored afterwards, use apply() to switch to the chosen settings.
+*/
+bool SweepAutoTuner::tuneBand(AnalyserObj<double> &analyser, const FrequencyBand &band, TuningResult &result) {
+	const double savedStartFreq = analyser.getStartFreq();
+	const double savedStopFreq = analyser.getStopFreq();
+	const double savedIFBW = analyser.getIFBW();
+	const int savedPoints = analyser.getSamplePoints();
+	const AnalyserFormat savedFormat = analyser.getFormat();
+
+	analyser.setFrequencyRange(band.startFreq, band.stopFreq);
+	analyser.setSamplePoints(m_calibrationPoints);
+	analyser.setIFBW(m_calibrationIFBW);
+	analyser.setFormat(SMIT);
+	while (!analyser.done());
+
+	std::vector<std::vector<double>> sweeps;
+	std::vector<double> noiseSweep;
+	bool captured = true;
+
+	for (int i = 0; i < m_calibrationSweeps && captured; i++) {
+		sweeps.push_back(analyser.captureData());
+		captured = !sweeps.back().empty();
+	}
+
+	// The noise floor is what is left with the source switched off
+	if (captured && m_measureNoiseFloor) {
+		analyser.sendCommand(":OUTP OFF");
+		noiseSweep = analyser.captureData();
+		analyser.sendCommand(":OUTP ON");
+		captured = !noiseSweep.empty();
+	}
+
+	analyser.setFrequencyRange(savedStartFreq, savedStopFreq);
+	analyser.setSamplePoints(savedPoints);
+	analyser.setIFBW(savedIFBW);
+	analyser.setFormat(savedFormat);
+	while (!analyser.done());
+
+	if (!captured) {
+		std::cerr << "Unable to capture the calibration sweeps of the band from " << band.startFreq << " to " << band.stopFreq << " Hz" << std::endl;
+		return false;
+	}
+
+	result = choose(band, sweeps, noiseSweep);
+
+	return true;
+}
+
+/*
+	Method which chooses the settings of a band from its calibration sweeps, i.e. interleaved complex traces captured with the calibration IFBW.
+	The noise sweep is optional: if it is empty, the noise floor is estimated from the spread between the sweeps.
+*/
+TuningResult SweepAutoTuner::choose(const FrequencyBand &band, const std::vector<std::vector<double>> &sweeps, const std::vector<double> &noiseSweep) const {
+	TuningResult result;
+	result.startFreq = band.startFreq;
+	result.stopFreq = band.stopFreq;
+
+	const std::size_t sweepCount = sweeps.size();
+	const std::size_t points = sweepCount > 0 ? sweeps[0].size() / 2 : 0;
+
+	// Mean of the sweeps at every point and the noise variance pooled over all the points
+	std::vector<std::complex<double>> mean(points);
+	std::vector<double> power(points);
+	double variance = 0;
+
+	for (std::size_t k = 0; k < points; k++) {
+		for (const std::vector<double> &sweep : sweeps) {
+			mean[k] += std::complex<double>(sweep[2 * k], sweep[2 * k + 1]);
+		}
+
+		mean[k] /= static_cast<double>(sweepCount);
+		power[k] = std::norm(mean[k]);
+
+		for (const std::vector<double> &sweep : sweeps) {
+			variance += std::norm(std::complex<double>(sweep[2 * k], sweep[2 * k + 1]) - mean[k]);
+		}
+	}
+
+	if (points > 0 && sweepCount > 1) {
+		variance /= static_cast<double>(points * (sweepCount - 1));
+	}
+
+	double noiseFloor = variance;
+
+	if (!noiseSweep.empty()) {
+		noiseFloor = 0;
+
+		for (std::size_t k = 0; k < noiseSweep.size() / 2; k++) {
+			noiseFloor += noiseSweep[2 * k] * noiseSweep[2 * k] + noiseSweep[2 * k + 1] * noiseSweep[2 * k + 1];
+		}
+
+		noiseFloor /= static_cast<double>(noiseSweep.size() / 2);
+	}
+
+	// Avoid dividing by zero for a noiseless (e.g. simulated) analyser
+	const double tiny = 1e-300;
+	noiseFloor = std::max(noiseFloor, tiny);
+
+	// Only the noise in the direction of the response changes its magnitude, which is half of the complex noise power
+	const double radialSigma = std::max(std::sqrt(variance / 2), tiny);
+
+	const double peak = std::max(points > 0 ? *std::max_element(power.begin(), power.end()) : 0.0, tiny);
+	const double rangeLimit = peak * std::pow(10.0, -m_target.uncertaintyRange / 10);
+
+	// The weakest response to which the uncertainty applies
+	double weakest = peak;
+
+	for (std::size_t k = 0; k < points; k++) {
+		if (power[k] >= rangeLimit) {
+			weakest = std::min(weakest, power[k]);
+		}
+	}
+
+	// Widest IFBW allowed by each part of the target. The noise power scales with the IFBW
+	const double calibrationRange = 10 * std::log10(peak / noiseFloor);
+	const double rangeIFBW = m_calibrationIFBW * std::pow(10.0, (calibrationRange - m_target.dynamicRange) / 10);
+
+	const double allowedRatio = std::pow(10.0, m_target.uncertainty / 20) - 1;
+	const double uncertaintyIFBW = m_calibrationIFBW * std::pow(allowedRatio * std::sqrt(weakest) / radialSigma, 2);
+
+	const double widestIFBW = std::min(rangeIFBW, uncertaintyIFBW);
+
+	result.IFBW = CANDIDATE_IFBWS[0];
+	result.meetsTarget = false;
+
+	for (int i = CANDIDATE_IFBW_COUNT - 1; i >= 0; i--) {
+		if (CANDIDATE_IFBWS[i] <= widestIFBW) {
+			result.IFBW = CANDIDATE_IFBWS[i];
+			result.meetsTarget = true;
+			break;
+		}
+	}
+
+	const double scale = result.IFBW / m_calibrationIFBW;
+	result.dynamicRange = calibrationRange - 10 * std::log10(scale);
+	result.uncertainty = 20 * std::log10(1 + radialSigma * std::sqrt(scale) / std::sqrt(weakest));
+
+	// Fewest points for which interpolating between them reproduces the mean of the calibration sweeps. Only point counts which divide the
+	// calibration points evenly are tried, so that every decimated point is also a calibration point.
+	// The tolerance at each point allows for the noise left on the mean, at the point itself and at the ends of its interval, so that the noise
+	// does not demand more points
+	const double meanSigma = radialSigma / std::sqrt(static_cast<double>(std::max<std::size_t>(sweepCount, 1)));
+	result.samplePoints = static_cast<int>(points);
+
+	for (std::size_t candidate = 2; candidate < points; candidate++) {
+		if ((points - 1) % (candidate - 1) != 0) {
+			continue;
+		}
+
+		const std::size_t step = (points - 1) / (candidate - 1);
+		bool accurate = true;
+
+		for (std::size_t k = 0; k < points && accurate; k++) {
+			if (power[k] < rangeLimit) {
+				continue;
+			}
+
+			std::size_t left = (k / step) * step;
+			std::size_t right = std::min(left + step, points - 1);
+			double fraction = (right > left) ? static_cast<double>(k - left) / (right - left) : 0.0;
+			double tolerance = m_target.interpolationError + 20 * std::log10(1 + 4 * meanSigma / std::sqrt(power[k]));
+			double error;
+
+			if (m_target.preservePhase) {
+				std::complex<double> interpolated = mean[left] + fraction * (mean[right] - mean[left]);
+				error = 20 * std::log10(1 + std::abs(interpolated - mean[k]) / std::sqrt(power[k]));
+			}
+			else {
+				double leftdB = 10 * std::log10(std::max(power[left], tiny));
+				double rightdB = 10 * std::log10(std::max(power[right], tiny));
+				error = std::abs(leftdB + fraction * (rightdB - leftdB) - 10 * std::log10(power[k]));
+			}
+
+			accurate = (error <= tolerance);
+		}
+
+		if (accurate) {
+			result.samplePoints = static_cast<int>(candidate);
+			break;
+		}
+	}
+
+	result.sweepTime = m_profile.getSweepTime(result.samplePoints, result.IFBW);
+
+	return result;
+}
+
+/*
+	Method which sets up the analyser with the settings chosen for a band
+*/
+bool SweepAutoTuner::apply(AnalyserObj<double> &analyser, const TuningResult &result) {
+	return analyser.setFrequencyRange(result.startFreq, result.stopFreq)
+		&& analyser.setSamplePoints(result.samplePoints)
+		&& analyser.setIFBW(result.IFBW);
+}
+
+/*
+	Setter methods
+*/
+
+void SweepAutoTuner::setTarget(const TuningTarget &target) {
+	m_target = target;
+}
+
+void SweepAutoTuner::setProfile(const LatencyProfile &profile) {
+	m_profile = profile;
+}
+
+void SweepAutoTuner::setCalibrationSweeps(int sweeps) {
+	m_calibrationSweeps = std::max(sweeps, 2);
+}
+
+void SweepAutoTuner::setCalibrationPoints(int samplePoints) {
+	m_calibrationPoints = std::max(samplePoints, 2);
+}
+
+void SweepAutoTuner::setCalibrationIFBW(double IFBW) {
+	m_calibrationIFBW = IFBW;
+}
+
+void SweepAutoTuner::setMeasureNoiseFloor(bool measureNoiseFloor) {
+	m_measureNoiseFloor = measureNoiseFloor;
+}
+
+/*
+	Getter methods
+*/
+
+const TuningTarget &SweepAutoTuner::getTarget() const {
+	return m_target;
+}
+
+int SweepAutoTuner::getCalibrationSweeps() const {
+	return m_calibrationSweeps;
+}
+
+int SweepAutoTuner::getCalibrationPoints() const {
+	return m_calibrationPoints;
+}
+
+double SweepAutoTuner::getCalibrationIFBW() const {
+	return m_calibrationIFBW;
+}
+
+bool SweepAutoTuner::getMeasureNoiseFloor() const {
+	return m_measureNoiseFloor;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "AnalyserObj.h"
+#include "LatencyProfile.h"
+#include <vector>
+
+/*
+	The accuracy required from the measurement of a band
+*/
+struct TuningTarget {
+	double dynamicRange; // Required distance in dB between the strongest response in the band and the noise floor
+	double uncertainty; // Largest allowed standard deviation of the magnitude in dB, caused by noise
+	double uncertaintyRange; // The uncertainty applies to responses down to this many dB below the strongest response in the band
+	double interpolationError; // Largest allowed error in dB when the response is linearly interpolated between the sample points
+	bool preservePhase; // Whether the phase must be interpolated correctly too, which needs more points if the response has a long delay
+
+	TuningTarget();
+};
+
+/*
+	A frequency band to be tuned
+*/
+struct FrequencyBand {
+	double startFreq;
+	double stopFreq;
+};
+
+/*
+	The settings chosen for a band and the accuracy they are expected to achieve
+*/
+struct TuningResult {
+	double startFreq;
+	double stopFreq;
+	double IFBW; // The widest IFBW which meets the target
+	int samplePoints; // The fewest sample points which meet the target
+	double dynamicRange; // Expected distance in dB between the strongest response and the noise floor
+	double uncertainty; // Expected standard deviation of the magnitude in dB at the weakest response within the uncertainty range
+	double sweepTime; // Expected time of a sweep in seconds, according to the latency profile
+	bool meetsTarget; // False if even the narrowest IFBW does not meet the target, in which case the narrowest IFBW is chosen
+};
+
+/*
+	Chooses the IFBW and the number of sample points for each band of a measurement, instead of measuring every band with the same fixed settings.
+	A few calibration sweeps are taken at a wide IFBW with the maximum number of points:
+	- the spread between repeated sweeps gives the noise on the trace, and a sweep with the source switched off gives the noise floor
+	- the noise power is proportional to the IFBW, which gives the widest IFBW for which the dynamic range and the uncertainty still meet the target
+	- the mean of the sweeps is decimated to fewer points and interpolated back, which gives the fewest points which still describe the response
+	The noise is assumed to dominate the spread between sweeps, i.e. drift is small over the few calibration sweeps.
+*/
+class SweepAutoTuner {
+private:
+	TuningTarget m_target;
+	LatencyProfile m_profile; // Used to predict the sweep time of the chosen settings
+	int m_calibrationSweeps; // Number of repeated calibration sweeps, at least 2
+	int m_calibrationPoints; // Number of points of the calibration sweeps. The chosen number of points divides this evenly
+	double m_calibrationIFBW; // IFBW of the calibration sweeps
+	bool m_measureNoiseFloor; // Whether to take a sweep with the source switched off to measure the noise floor
+
+public:
+	SweepAutoTuner(const TuningTarget &target = TuningTarget());
+
+	bool tune(AnalyserObj<double> &analyser, const std::vector<FrequencyBand> &bands, std::vector<TuningResult> &results);
+	bool tuneBand(AnalyserObj<double> &analyser, const FrequencyBand &band, TuningResult &result);
+	TuningResult choose(const FrequencyBand &band, const std::vector<std::vector<double>> &sweeps, const std::vector<double> &noiseSweep) const;
+
+	static bool apply(AnalyserObj<double> &analyser, const TuningResult &result);
+
+	/*
+		Setter methods
+	*/
+	void setTarget(const TuningTarget &target);
+	void setProfile(const LatencyProfile &profile);
+	void setCalibrationSweeps(int sweeps);
+	void setCalibrationPoints(int samplePoints);
+	void setCalibrationIFBW(double IFBW);
+	void setMeasureNoiseFloor(bool measureNoiseFloor);
+
+	/*
+		Getter methods
+	*/
+	const TuningTarget &getTarget() const;
+	int getCalibrationSweeps() const;
+	int getCalibrationPoints() const;
+	double getCalibrationIFBW() const;
+	bool getMeasureNoiseFloor() const;
+};
@@ -0,0 +1,190 @@
+#include "SweepStreamServer.h"
+#include <cstring>
+#include <iostream>
+
+/*
+	Constructor of the SweepStreamServer. The server starts listening for clients on the given port straight away.
+	With DROP_OLDEST at least 2 frames are queued, since the frame at the front of the queue may be in the middle of being written and cannot be dropped
+*/
+SweepStreamServer::SweepStreamServer(int port, std::size_t maxQueuedFrames, StreamDropPolicy dropPolicy)
+	: m_acceptor(m_ioservice), m_port(port), m_maxQueuedFrames(std::max<std::size_t>(maxQueuedFrames, (dropPolicy == DROP_OLDEST) ? 2 : 1)), m_dropPolicy(dropPolicy), m_sequence(0), m_clientCount(0), m_droppedFrames(0) {
+	try {
+		boost::asio::ip::tcp::endpoint ep(boost::asio::ip::tcp::v4(), port);
+
+		m_acceptor.open(ep.protocol());
+		m_acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+		m_acceptor.bind(ep);
+		m_acceptor.listen();
+
+		// Store the port actually used, in case port 0 was requested to let the operating system choose one
+		m_port = m_acceptor.local_endpoint().port();
+	}
+	catch (boost::system::system_error &e) {
+		std::cerr << "An error occured attempting to start the sweep stream server" << std::endl;
+		std::cerr << "Error code: " << e.code() << std::endl;
+		std::cerr << "Error Message: " << e.what() << std::endl;
+
+		throw e;
+	}
+
+	m_work.reset(new boost::asio::io_service::work(m_ioservice));
+
+	startAccept();
+
+	m_thread = boost::thread([this]() { m_ioservice.run(); });
+}
+
+/*
+	Method which waits for the next client to connect
+*/
+void SweepStreamServer::startAccept() {
+	boost::shared_ptr<StreamClient> client(new StreamClient(m_ioservice));
+
+	m_acceptor.async_accept(client->socket, [this, client](const boost::system::error_code &ec) {
+		if (ec) {
+			// The acceptor is closed when the server is stopped
+			return;
+		}
+
+		boost::system::error_code ignored;
+		client->socket.set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+
+		m_clients.insert(client);
+		m_clientCount = static_cast<int>(m_clients.size());
+
+		startAccept();
+	});
+}
+
+/*
+	Method which publishes a trace to all the connected clients. The trace is serialised here, on the calling thread, and the rest of the work
+	is handed over to the server thread, so this method returns straight away
+*/
+void SweepStreamServer::publish(const MeasurementTrace &trace) {
+	StreamFrameHeader header;
+	std::memcpy(header.magic, "CMTS", 4);
+	header.headerSize = sizeof(StreamFrameHeader);
+	header.sequence = m_sequence++;
+	header.angle = trace.angle;
+	header.startFreq = trace.startFreq;
+	header.stopFreq = trace.stopFreq;
+	header.parameter = trace.parameter;
+	header.format = trace.format;
+	header.samplePoints = trace.getSamplePoints();
+	header.reserved = 0;
+
+	std::size_t dataSize = trace.data.size() * sizeof(double);
+
+	boost::shared_ptr<std::vector<char>> frame(new std::vector<char>(sizeof(header) + dataSize));
+	std::memcpy(frame->data(), &header, sizeof(header));
+	std::memcpy(frame->data() + sizeof(header), trace.data.data(), dataSize);
+
+	Frame sharedFrame(frame);
+	m_ioservice.post([this, sharedFrame]() { enqueue(sharedFrame); });
+}
+
+/*
+	Method which queues a frame for every client. Runs on the server thread
+*/
+void SweepStreamServer::enqueue(Frame frame) {
+	std::vector<boost::shared_ptr<StreamClient>> disconnected;
+
+	for (const boost::shared_ptr<StreamClient> &client : m_clients) {
+		if (client->queue.size() >= m_maxQueuedFrames) {
+			m_droppedFrames++;
+
+			if (m_dropPolicy == DROP_NEWEST) {
+				continue;
+			}
+			else if (m_dropPolicy == DISCONNECT) {
+				disconnected.push_back(client);
+				continue;
+			}
+			else {
+				// The frame at the front may be in the middle of being written, so the oldest frame after it is dropped instead
+				client->queue.erase(client->queue.begin() + (client->writing ? 1 : 0));
+			}
+		}
+
+		client->queue.push_back(frame);
+
+		if (!client->writing) {
+			startWrite(client);
+		}
+	}
+
+	for (const boost::shared_ptr<StreamClient> &client : disconnected) {
+		removeClient(client);
+	}
+}
+
+/*
+	Method which sends the frame at the front of the queue of a client. Runs on the server thread
+*/
+void SweepStreamServer::startWrite(boost::shared_ptr<StreamClient> client) {
+	client->writing = true;
+
+	// The frame is captured by the handler to keep it alive until it has been written
+	Frame frame = client->queue.front();
+
+	boost::asio::async_write(client->socket, boost::asio::buffer(*frame), [this, client, frame](const boost::system::error_code &ec, std::size_t) {
+		client->writing = false;
+
+		// The client may have been disconnected by enqueue() or the destructor while the write was finishing, in which case its queue is empty
+		if (m_clients.count(client) == 0 || client->queue.empty()) {
+			return;
+		}
+
+		if (ec) {
+			removeClient(client);
+			return;
+		}
+
+		client->queue.pop_front();
+
+		if (!client->queue.empty()) {
+			startWrite(client);
+		}
+	});
+}
+
+/*
+	Method which disconnects a client. Runs on the server thread
+*/
+void SweepStreamServer::removeClient(boost::shared_ptr<StreamClient> client) {
+	boost::system::error_code ignored;
+	client->socket.close(ignored);
+	client->queue.clear();
+
+	m_clients.erase(client);
+	m_clientCount = static_cast<int>(m_clients.size());
+}
+
+int SweepStreamServer::getPort() {
+	return m_port;
+}
+
+int SweepStreamServer::getClientCount() {
+	return m_clientCount;
+}
+
+std::uint64_t SweepStreamServer::getDroppedFrameCount() {
+	return m_droppedFrames;
+}
+
+/*
+	Destructor of the SweepStreamServer. Disconnects all the clients and stops the server thread
+*/
+SweepStreamServer::~SweepStreamServer() {
+	m_ioservice.post([this]() {
+		boost::system::error_code ignored;
+		m_acceptor.close(ignored);
+
+		while (!m_clients.empty()) {
+			removeClient(*m_clients.begin());
+		}
+	});
+
+	m_work.reset();
+	m_thread.join();
+}
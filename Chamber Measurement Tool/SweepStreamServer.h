@@ -0,0 +1,93 @@
+#pragma once
+#include "MeasurementTrace.h"
+#include <boost/asio.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <set>
+#include <vector>
+
+/*
+	Policy which decides what happens to a client which is not reading the stream as fast as the traces are being published
+*/
+enum StreamDropPolicy {
+	DROP_OLDEST, // Discard the oldest trace waiting to be sent to the client. At least 2 traces are queued with this policy
+	DROP_NEWEST, // Discard the trace which is being published
+	DISCONNECT // Disconnect the client
+};
+
+/*
+	Header which is sent in front of every trace. It is followed by samplePoints x 2 doubles of interleaved real and imaginary data.
+	All values are sent in the byte order of the computer running the measurement (little endian on a PC)
+*/
+#pragma pack(push, 8)
+struct StreamFrameHeader {
+	char magic[4]; // Always "CMTS"
+	std::uint32_t headerSize; // Size of this header in bytes, so that clients can skip fields added in future versions
+	std::uint64_t sequence; // Number of the trace since the server was started. Gaps show that traces were dropped
+	double angle;
+	double startFreq;
+	double stopFreq;
+	std::int32_t parameter;
+	std::int32_t format;
+	std::int32_t samplePoints;
+	std::int32_t reserved;
+};
+#pragma pack(pop)
+
+/*
+	Server which streams every published trace to all the connected TCP clients, so that a measurement can be watched while it is in progress.
+	Each trace is serialised once into a shared buffer which is queued for every client, so the cost of publishing does not grow with the number
+	of clients. All the network communication happens on a separate thread, so publish() never waits for the network. A client which falls behind
+	by more than the maximum number of queued traces is dealt with according to the drop policy.
+*/
+class SweepStreamServer {
+private:
+	typedef boost::shared_ptr<const std::vector<char>> Frame;
+
+	/*
+		A single connected client, with the frames which still need to be sent to it
+	*/
+	class StreamClient {
+	public:
+		boost::asio::ip::tcp::socket socket;
+		std::deque<Frame> queue;
+		bool writing;
+
+		StreamClient(boost::asio::io_service &ioservice) : socket(ioservice), writing(false) {}
+	};
+
+	boost::asio::io_service m_ioservice; // Runs all the network communication on the server thread
+	boost::scoped_ptr<boost::asio::io_service::work> m_work; // Keeps the server thread running while there is nothing to do
+	boost::asio::ip::tcp::acceptor m_acceptor; // Accepts new clients
+	boost::thread m_thread; // The server thread
+
+	std::set<boost::shared_ptr<StreamClient>> m_clients; // The connected clients. Only used on the server thread
+
+	int m_port;
+	std::size_t m_maxQueuedFrames;
+	StreamDropPolicy m_dropPolicy;
+
+	std::uint64_t m_sequence; // Sequence number of the next trace
+	std::atomic<int> m_clientCount;
+	std::atomic<std::uint64_t> m_droppedFrames;
+
+	void startAccept();
+	void enqueue(Frame frame);
+	void startWrite(boost::shared_ptr<StreamClient> client);
+	void removeClient(boost::shared_ptr<StreamClient> client);
+
+public:
+	SweepStreamServer(int port = 5050, std::size_t maxQueuedFrames = 16, StreamDropPolicy dropPolicy = DROP_OLDEST);
+
+	void publish(const MeasurementTrace &trace);
+
+	int getPort();
+	int getClientCount();
+	std::uint64_t getDroppedFrameCount();
+
+	~SweepStreamServer();
+};
@@ -0,0 +1,541 @@
+#include "TraceCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/*
+	How a trace is predicted. Only the frequency predictors can be used for the first trace of a group
+*/
+enum TracePredictor {
+	PREDICT_FREQUENCY = 0, // The previous sample point
+	PREDICT_FREQUENCY_LINEAR = 1, // Linear extrapolation of the previous two sample points
+	PREDICT_ANGLE = 2, // The same sample point at the previous angle
+	PREDICT_PLANE = 3 // The same sample point at the previous angle, plus the change between the previous sample points at that angle
+};
+
+/*
+	How a byte plane is stored
+*/
+enum PlaneMode {
+	PLANE_CONSTANT = 0, // Every byte has the same value, which is stored once
+	PLANE_RAW = 1, // The bytes are stored as is
+	PLANE_RANS = 2 // The frequency table followed by the size and the output of the rANS coder
+};
+
+static const int RANS_SCALE_BITS = 12; // The frequencies of the symbols add up to 1 << RANS_SCALE_BITS
+static const std::uint32_t RANS_SCALE = 1u << RANS_SCALE_BITS;
+static const std::uint32_t RANS_LOWER = 1u << 16; // Lower bound of the normalised state of the rANS coder, which reads and writes 16 bits at a time
+
+/*
+	Mapping between doubles and integers which sort in the same order, for traces with the full precision of a double. Negative values have all
+	their bits inverted and positive values only their sign bit. The mapping is done without branches since the sign of the data is not predictable
+*/
+struct DoublePrecision {
+	typedef std::uint64_t Word;
+	static const int BYTES = 8;
+
+	static Word toWord(double value) {
+		Word bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		return bits ^ (static_cast<Word>(static_cast<std::int64_t>(bits) >> 63) | (Word(1) << 63));
+	}
+
+	static double fromWord(Word word) {
+		Word bits = word ^ (static_cast<Word>(static_cast<std::int64_t>(~word) >> 63) | (Word(1) << 63));
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+
+		return value;
+	}
+};
+
+/*
+	The same mapping for traces which were transferred as REAL32, so that every value is exactly a float
+*/
+struct FloatPrecision {
+	typedef std::uint32_t Word;
+	static const int BYTES = 4;
+
+	static Word toWord(double value) {
+		float single = static_cast<float>(value);
+		Word bits;
+		std::memcpy(&bits, &single, sizeof(bits));
+
+		return bits ^ (static_cast<Word>(static_cast<std::int32_t>(bits) >> 31) | (Word(1) << 31));
+	}
+
+	static double fromWord(Word word) {
+		Word bits = word ^ (static_cast<Word>(static_cast<std::int32_t>(~word) >> 31) | (Word(1) << 31));
+		float single;
+		std::memcpy(&single, &bits, sizeof(single));
+
+		return single;
+	}
+};
+
+/*
+	Predicts value i of a trace from the values before it. Real and imaginary values are interleaved, so the previous sample point of the same
+	component is two values back
+*/
+static inline double predict(int predictor, const double *trace, const double *previous, std::size_t i) {
+	switch (predictor) {
+	case PREDICT_FREQUENCY_LINEAR:
+		if (i >= 4) {
+			return 2 * trace[i - 2] - trace[i - 4];
+		}
+		return (i >= 2) ? trace[i - 2] : 0.0;
+	case PREDICT_ANGLE:
+		return previous[i];
+	case PREDICT_PLANE:
+		return (i >= 2) ? previous[i] + (trace[i - 2] - previous[i - 2]) : previous[i];
+	default:
+		return (i >= 2) ? trace[i - 2] : 0.0;
+	}
+}
+
+/*
+	Folds the sign of a residual into its lowest bit so that small negative residuals also have their upper bytes zero, and the inverse
+*/
+template<class P> static inline std::uint64_t zigzag(typename P::Word difference) {
+	const typename P::Word sign = 0 - (difference >> (8 * P::BYTES - 1));
+
+	return static_cast<typename P::Word>((difference << 1) ^ sign);
+}
+
+template<class P> static inline typename P::Word unzigzag(std::uint64_t residual) {
+	const typename P::Word folded = static_cast<typename P::Word>(residual);
+
+	return static_cast<typename P::Word>((folded >> 1) ^ (0 - (folded & 1)));
+}
+
+/*
+	Computes the residuals of a trace with the given predictor and returns the number of bytes which are not zero, as an estimate of the
+	size of the encoded trace
+*/
+template<class P> static std::size_t computeResiduals(const double *trace, const double *previous, std::size_t values, int predictor, std::uint64_t *residuals) {
+	std::size_t cost = 0;
+
+	for (std::size_t i = 0; i < values; i++) {
+		const typename P::Word difference = static_cast<typename P::Word>(P::toWord(trace[i]) - P::toWord(predict(predictor, trace, previous, i)));
+		std::uint64_t residual = zigzag<P>(difference);
+		residuals[i] = residual;
+
+		while (residual) {
+			residual >>= 8;
+			cost++;
+		}
+	}
+
+	return cost;
+}
+
+/*
+	Chooses the predictor of every trace of a group and computes the residuals
+*/
+template<class P> static void predictTraces(const double *data, std::size_t traceCount, std::size_t values, std::vector<char> &out, std::uint64_t *residuals) {
+	for (std::size_t t = 0; t < traceCount; t++) {
+		const double *trace = data + t * values;
+		const double *previous = (t > 0) ? trace - values : nullptr;
+		const int predictorCount = (t > 0) ? 4 : 2;
+
+		int best = PREDICT_FREQUENCY;
+		std::size_t bestCost = computeResiduals<P>(trace, previous, values, PREDICT_FREQUENCY, residuals + t * values);
+
+		for (int predictor = 1; predictor < predictorCount; predictor++) {
+			std::size_t cost = computeResiduals<P>(trace, previous, values, predictor, residuals + t * values);
+
+			if (cost < bestCost) {
+				best = predictor;
+				bestCost = cost;
+			}
+		}
+
+		if (best != predictorCount - 1) {
+			computeResiduals<P>(trace, previous, values, best, residuals + t * values);
+		}
+
+		out.push_back(static_cast<char>(best));
+	}
+}
+
+/*
+	Reconstructs a trace from its residuals. The predictor is a template parameter so that it is not chosen again for every value
+*/
+template<class P, int PREDICTOR> static void reconstructTrace(const std::uint64_t *residuals, std::size_t values, const double *previous, double *trace) {
+	for (std::size_t i = 0; i < values; i++) {
+		const typename P::Word word = static_cast<typename P::Word>(P::toWord(predict(PREDICTOR, trace, previous, i)) + unzigzag<P>(residuals[i]));
+		trace[i] = P::fromWord(word);
+	}
+}
+
+/*
+	Reverses predictTraces
+*/
+template<class P> static void reconstructTraces(const std::uint64_t *residuals, const unsigned char *predictors, std::size_t traceCount, std::size_t values, double *data) {
+	for (std::size_t t = 0; t < traceCount; t++) {
+		double *trace = data + t * values;
+		const double *previous = (t > 0) ? trace - values : nullptr;
+
+		switch (predictors[t]) {
+		case PREDICT_FREQUENCY_LINEAR:
+			reconstructTrace<P, PREDICT_FREQUENCY_LINEAR>(residuals + t * values, values, previous, trace);
+			break;
+		case PREDICT_ANGLE:
+			reconstructTrace<P, PREDICT_ANGLE>(residuals + t * values, values, previous, trace);
+			break;
+		case PREDICT_PLANE:
+			reconstructTrace<P, PREDICT_PLANE>(residuals + t * values, values, previous, trace);
+			break;
+		default:
+			reconstructTrace<P, PREDICT_FREQUENCY>(residuals + t * values, values, previous, trace);
+			break;
+		}
+	}
+}
+
+/*
+	Scales the counts of the symbols so that they add up to RANS_SCALE, keeping every symbol which occurs at a frequency of at least 1
+*/
+static void normaliseFrequencies(const std::uint32_t *counts, std::size_t total, std::uint32_t *frequencies) {
+	std::uint32_t sum = 0;
+	int largest = 0;
+
+	for (int s = 0; s < 256; s++) {
+		frequencies[s] = 0;
+
+		if (counts[s] > 0) {
+			frequencies[s] = std::max<std::uint32_t>(1, static_cast<std::uint32_t>((static_cast<std::uint64_t>(counts[s]) * RANS_SCALE + total / 2) / total));
+			sum += frequencies[s];
+		}
+
+		if (counts[s] > counts[largest]) {
+			largest = s;
+		}
+	}
+
+	// The rounding error is taken from the most frequent symbols, where it costs the least
+	while (sum > RANS_SCALE) {
+		int target = 0;
+
+		for (int s = 1; s < 256; s++) {
+			if (frequencies[s] > frequencies[target]) {
+				target = s;
+			}
+		}
+
+		std::uint32_t reduction = std::min(sum - RANS_SCALE, frequencies[target] - 1);
+		frequencies[target] -= reduction;
+		sum -= reduction;
+	}
+
+	frequencies[largest] += RANS_SCALE - sum;
+}
+
+/*
+	Appends a byte plane to the output, choosing the smallest of the three ways to store it
+*/
+void TraceCodec::encodePlane(const unsigned char *plane, std::size_t length, std::vector<char> &out) {
+	std::uint32_t counts[256] = {};
+
+	for (std::size_t i = 0; i < length; i++) {
+		counts[plane[i]]++;
+	}
+
+	const int symbolCount = static_cast<int>(256 - std::count(counts, counts + 256, 0u));
+
+	if (symbolCount <= 1) {
+		out.push_back(PLANE_CONSTANT);
+		out.push_back(static_cast<char>(length > 0 ? plane[0] : 0));
+		return;
+	}
+
+	std::uint32_t frequencies[256];
+	std::uint32_t cumulative[256];
+	normaliseFrequencies(counts, length, frequencies);
+
+	// Skip the entropy coder for planes which are mostly noise, e.g. the lowest bytes of the residuals
+	const std::size_t tableSize = 32 + 2 * symbolCount + 4;
+	double bits = 0;
+
+	for (int s = 0, start = 0; s < 256; s++) {
+		cumulative[s] = start;
+		start += frequencies[s];
+
+		if (counts[s] > 0) {
+			bits += counts[s] * (RANS_SCALE_BITS - std::log2(static_cast<double>(frequencies[s])));
+		}
+	}
+
+	if (tableSize + static_cast<std::size_t>(bits / 8) + 8 >= length) {
+		out.push_back(PLANE_RAW);
+		out.insert(out.end(), reinterpret_cast<const char *>(plane), reinterpret_cast<const char *>(plane) + length);
+		return;
+	}
+
+	// The symbols are encoded in reverse, alternating between two states so that the decoder can work on both at the same time.
+	// Every symbol writes at most one 16 bit word
+	m_entropyBuffer.resize(2 * length + 8);
+	unsigned char *const end = m_entropyBuffer.data() + m_entropyBuffer.size();
+	unsigned char *position = end;
+	std::uint32_t states[2] = { RANS_LOWER, RANS_LOWER };
+
+	for (std::size_t i = length; i-- > 0;) {
+		std::uint32_t &state = states[i & 1];
+		const std::uint32_t frequency = frequencies[plane[i]];
+		const std::uint32_t limit = ((RANS_LOWER >> RANS_SCALE_BITS) << 16) * frequency;
+
+		if (state >= limit) {
+			position -= 2;
+			position[0] = static_cast<unsigned char>(state);
+			position[1] = static_cast<unsigned char>(state >> 8);
+			state >>= 16;
+		}
+
+		state = ((state / frequency) << RANS_SCALE_BITS) + (state % frequency) + cumulative[plane[i]];
+	}
+
+	for (int s = 1; s >= 0; s--) {
+		position -= 4;
+
+		for (int b = 0; b < 4; b++) {
+			position[b] = static_cast<unsigned char>(states[s] >> (8 * b));
+		}
+	}
+
+	const std::uint32_t encodedSize = static_cast<std::uint32_t>(end - position);
+
+	if (tableSize + encodedSize >= length) {
+		out.push_back(PLANE_RAW);
+		out.insert(out.end(), reinterpret_cast<const char *>(plane), reinterpret_cast<const char *>(plane) + length);
+		return;
+	}
+
+	out.push_back(PLANE_RANS);
+
+	char bitmap[32] = {};
+
+	for (int s = 0; s < 256; s++) {
+		if (counts[s] > 0) {
+			bitmap[s >> 3] |= static_cast<char>(1 << (s & 7));
+		}
+	}
+
+	out.insert(out.end(), bitmap, bitmap + sizeof(bitmap));
+
+	for (int s = 0; s < 256; s++) {
+		if (counts[s] > 0) {
+			out.push_back(static_cast<char>(frequencies[s]));
+			out.push_back(static_cast<char>(frequencies[s] >> 8));
+		}
+	}
+
+	for (int b = 0; b < 4; b++) {
+		out.push_back(static_cast<char>(encodedSize >> (8 * b)));
+	}
+
+	out.insert(out.end(), reinterpret_cast<const char *>(position), reinterpret_cast<const char *>(end));
+}
+
+/*
+	Reads a byte plane written by encodePlane and advances in past it. Returns false if the data is not valid
+*/
+bool TraceCodec::decodePlane(const char *&in, const char *end, unsigned char *plane, std::size_t length) {
+	if (in >= end) {
+		return false;
+	}
+
+	const int mode = static_cast<unsigned char>(*in++);
+
+	if (mode == PLANE_CONSTANT) {
+		if (in >= end) {
+			return false;
+		}
+
+		std::memset(plane, static_cast<unsigned char>(*in++), length);
+		return true;
+	}
+
+	if (mode == PLANE_RAW) {
+		if (static_cast<std::size_t>(end - in) < length) {
+			return false;
+		}
+
+		std::memcpy(plane, in, length);
+		in += length;
+		return true;
+	}
+
+	if (mode != PLANE_RANS || end - in < 32) {
+		return false;
+	}
+
+	const unsigned char *bitmap = reinterpret_cast<const unsigned char *>(in);
+	in += 32;
+
+	// Every slot of the state holds its symbol in the lowest 8 bits, the frequency of the symbol in the next 12 bits and the position of the
+	// slot within the symbol in the top 12 bits
+	std::uint32_t slots[RANS_SCALE];
+	std::uint32_t start = 0;
+
+	for (int s = 0; s < 256; s++) {
+		if (bitmap[s >> 3] & (1 << (s & 7))) {
+			if (end - in < 2) {
+				return false;
+			}
+
+			const std::uint32_t frequency = static_cast<unsigned char>(in[0]) | (static_cast<unsigned char>(in[1]) << 8);
+			in += 2;
+
+			if (frequency == 0 || frequency >= RANS_SCALE || start + frequency > RANS_SCALE) {
+				return false;
+			}
+
+			for (std::uint32_t i = 0; i < frequency; i++) {
+				slots[start + i] = s | (frequency << 8) | (i << 20);
+			}
+
+			start += frequency;
+		}
+	}
+
+	if (start != RANS_SCALE || end - in < 4) {
+		return false;
+	}
+
+	std::uint32_t encodedSize = 0;
+
+	for (int b = 0; b < 4; b++) {
+		encodedSize |= static_cast<std::uint32_t>(static_cast<unsigned char>(in[b])) << (8 * b);
+	}
+
+	in += 4;
+
+	if (encodedSize < 8 || static_cast<std::size_t>(end - in) < encodedSize) {
+		return false;
+	}
+
+	const unsigned char *position = reinterpret_cast<const unsigned char *>(in);
+	const unsigned char *const encodedEnd = position + encodedSize;
+	std::uint32_t states[2] = { 0, 0 };
+
+	for (int s = 0; s < 2; s++) {
+		for (int b = 0; b < 4; b++) {
+			states[s] |= static_cast<std::uint32_t>(*position++) << (8 * b);
+		}
+	}
+
+	// The state is renormalised without a branch, since whether a word is read is as unpredictable as the data. Past the end of the data the
+	// word is read from a padding word instead and the plane is rejected afterwards
+	static const unsigned char padding[2] = {};
+	bool overrun = false;
+
+	for (std::size_t i = 0; i < length; i++) {
+		std::uint32_t &state = states[i & 1];
+		const std::uint32_t slot = slots[state & (RANS_SCALE - 1)];
+
+		state = ((slot >> 8) & (RANS_SCALE - 1)) * (state >> RANS_SCALE_BITS) + (slot >> 20);
+		plane[i] = static_cast<unsigned char>(slot);
+
+		const bool renormalise = (state < RANS_LOWER);
+		const bool available = (encodedEnd - position >= 2);
+		const unsigned char *word = available ? position : padding;
+
+		overrun |= (renormalise && !available);
+		state = renormalise ? ((state << 16) | word[0] | (word[1] << 8)) : state;
+		position += (renormalise && available) ? 2 : 0;
+	}
+
+	if (overrun) {
+		return false;
+	}
+
+	in += encodedSize;
+
+	return true;
+}
+
+/*
+	Encodes a group of traces captured at consecutive angles and appends the result to out. The data holds traceCount traces of samplePoints
+	interleaved real and imaginary values each
+*/
+void TraceCodec::encode(const double *data, std::size_t traceCount, std::size_t samplePoints, std::vector<char> &out) {
+	const std::size_t values = 2 * samplePoints;
+	const std::size_t total = traceCount * values;
+
+	// Only use the float planes if converting every value to a float and back gives exactly the same bits
+	bool single = true;
+
+	for (std::size_t i = 0; i < total && single; i++) {
+		const double converted = static_cast<float>(data[i]);
+		single = (std::memcmp(&converted, &data[i], sizeof(double)) == 0);
+	}
+
+	out.push_back(single ? 1 : 0);
+
+	m_residuals.resize(total);
+
+	if (single) {
+		predictTraces<FloatPrecision>(data, traceCount, values, out, m_residuals.data());
+	}
+	else {
+		predictTraces<DoublePrecision>(data, traceCount, values, out, m_residuals.data());
+	}
+
+	const int planeCount = single ? FloatPrecision::BYTES : DoublePrecision::BYTES;
+	m_plane.resize(total);
+
+	for (int p = 0; p < planeCount; p++) {
+		for (std::size_t i = 0; i < total; i++) {
+			m_plane[i] = static_cast<unsigned char>(m_residuals[i] >> (8 * p));
+		}
+
+		encodePlane(m_plane.data(), total, out);
+	}
+}
+
+/*
+	Decodes a group of traces written by encode. Returns false if the data is not valid
+*/
+bool TraceCodec::decode(const char *in, std::size_t length, std::size_t traceCount, std::size_t samplePoints, double *data) {
+	const char *const end = in + length;
+	const std::size_t values = 2 * samplePoints;
+	const std::size_t total = traceCount * values;
+
+	if (length < 1 + traceCount) {
+		return false;
+	}
+
+	const bool single = (*in++ != 0);
+	const unsigned char *predictors = reinterpret_cast<const unsigned char *>(in);
+	in += traceCount;
+
+	for (std::size_t t = 0; t < traceCount; t++) {
+		if (predictors[t] > PREDICT_PLANE || (t == 0 && predictors[t] > PREDICT_FREQUENCY_LINEAR)) {
+			return false;
+		}
+	}
+
+	const int planeCount = single ? FloatPrecision::BYTES : DoublePrecision::BYTES;
+	m_residuals.assign(total, 0);
+	m_plane.resize(total);
+
+	for (int p = 0; p < planeCount; p++) {
+		if (!decodePlane(in, end, m_plane.data(), total)) {
+			return false;
+		}
+
+		for (std::size_t i = 0; i < total; i++) {
+			m_residuals[i] |= static_cast<std::uint64_t>(m_plane[i]) << (8 * p);
+		}
+	}
+
+	if (single) {
+		reconstructTraces<FloatPrecision>(m_residuals.data(), predictors, traceCount, values, data);
+	}
+	else {
+		reconstructTraces<DoublePrecision>(m_residuals.data(), predictors, traceCount, values, data);
+	}
+
+	return true;
+}
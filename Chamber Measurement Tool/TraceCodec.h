@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/*
+	Lossless codec for groups of traces captured at consecutive angles, used for the compressed measurement files of the archive.
+	A trace is a sequence of interleaved real and imaginary doubles. Every value is encoded as follows:
+	- the value is predicted from its neighbours, i.e. the same value at the previous angle and/or the previous sample point, using plain
+	  double arithmetic so that the decoder computes exactly the same prediction
+	- the value and the prediction are mapped to integers which are ordered in the same way as the doubles, and the difference between the two is
+	  the residual. Values which are close together give a small residual, even across a power of two
+	- the residuals of the group are split into byte planes, i.e. all the least significant bytes followed by all the next bytes and so on.
+	  The upper planes of a well predicted trace are mostly zero
+	- every byte plane is stored as a single byte if it is constant, as is if it is noise, or otherwise with an order 0 rANS entropy coder
+	The predictor which gives the smallest residuals is chosen for every trace. Data transferred as REAL32 only has the precision of a float,
+	which is detected per group so that only 4 byte planes are stored.
+	A group can be decoded on its own, the first trace of a group is only predicted along the frequency axis.
+*/
+class TraceCodec {
+private:
+	std::vector<std::uint64_t> m_residuals; // Residuals of the group which is being encoded or decoded
+	std::vector<unsigned char> m_plane; // A byte plane of the residuals
+	std::vector<unsigned char> m_entropyBuffer; // Output of the entropy coder
+
+	void encodePlane(const unsigned char *plane, std::size_t length, std::vector<char> &out);
+	bool decodePlane(const char *&in, const char *end, unsigned char *plane, std::size_t length);
+
+public:
+	void encode(const double *data, std::size_t traceCount, std::size_t samplePoints, std::vector<char> &out);
+	bool decode(const char *in, std::size_t length, std::size_t traceCount, std::size_t samplePoints, double *data);
+};
@@ -0,0 +1,177 @@
+#include "TransportCapture.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+/*
+	Writes a variable length integer to out and returns the end of the written bytes. At most 10 bytes are written
+*/
+static char *writeVarint(char *out, std::uint64_t value) {
+	while (value >= 0x80) {
+		*out++ = static_cast<char>((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+
+	*out++ = static_cast<char>(value);
+
+	return out;
+}
+
+/*
+	Reads a variable length integer starting at position. Returns false if the data ends before the integer does
+*/
+static bool readVarint(const std::vector<char> &data, std::size_t &position, std::uint64_t &value) {
+	value = 0;
+
+	for (int shift = 0; shift < 64 && position < data.size(); shift += 7) {
+		unsigned char byte = static_cast<unsigned char>(data[position++]);
+		value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+TransportRecorder::TransportRecorder() : m_writer(1 << 16), m_lastMicroseconds(0), m_recordCount(0) {
+}
+
+/*
+	Creates a capture file, overwriting any existing file. The times of the records are measured from this point
+*/
+bool TransportRecorder::open(const std::string &path) {
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	if (!m_writer.open(path)) {
+		return false;
+	}
+
+	m_writer.write(CAPTUREFILE_MAGIC, sizeof(CAPTUREFILE_MAGIC));
+	m_writer.write(reinterpret_cast<const char *>(&CAPTUREFILE_VERSION), sizeof(CAPTUREFILE_VERSION));
+
+	m_start = boost::chrono::steady_clock::now();
+	m_lastMicroseconds = 0;
+	m_recordCount = 0;
+
+	return true;
+}
+
+/*
+	Writes the remaining records to the file and closes it. Returns false if any write to the file failed
+*/
+bool TransportRecorder::close() {
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	return m_writer.close();
+}
+
+bool TransportRecorder::isOpen() {
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	return m_writer.isOpen();
+}
+
+/*
+	Appends a record to the capture file. Nothing is recorded if the file is not open
+*/
+void TransportRecorder::record(CaptureChannel channel, CaptureDirection direction, const void *data, std::size_t length) {
+	boost::chrono::steady_clock::time_point now = boost::chrono::steady_clock::now();
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	if (!m_writer.isOpen() || length == 0) {
+		return;
+	}
+
+	std::uint64_t microseconds = boost::chrono::duration_cast<boost::chrono::microseconds>(now - m_start).count();
+
+	// Records from different threads can take the lock out of order, in which case the later one is given the same time
+	if (microseconds < m_lastMicroseconds) {
+		microseconds = m_lastMicroseconds;
+	}
+
+	char *out = m_writer.reserve(21 + length);
+	out = writeVarint(out, microseconds - m_lastMicroseconds);
+	*out++ = static_cast<char>((channel << 1) | direction);
+	out = writeVarint(out, length);
+	std::memcpy(out, data, length);
+	m_writer.commit(out + length);
+
+	m_lastMicroseconds = microseconds;
+	m_recordCount++;
+}
+
+std::uint64_t TransportRecorder::getRecordCount() {
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	return m_recordCount;
+}
+
+TransportRecorder::~TransportRecorder() {
+	close();
+}
+
+/*
+	Reads all the records of a capture file. Returns false if the file could not be read or is not a valid capture file
+*/
+bool readCapture(const std::string &path, std::vector<CaptureRecord> &records) {
+	records.clear();
+
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file) {
+		std::cerr << "Unable to open the capture file " << path << std::endl;
+		return false;
+	}
+
+	std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	std::uint32_t version = 0;
+
+	if (data.size() < 8 || std::memcmp(data.data(), CAPTUREFILE_MAGIC, 4) != 0) {
+		std::cerr << path << " is not a capture file" << std::endl;
+		return false;
+	}
+
+	std::memcpy(&version, data.data() + 4, sizeof(version));
+
+	if (version != CAPTUREFILE_VERSION) {
+		std::cerr << "The capture file " << path << " has an unsupported version" << std::endl;
+		return false;
+	}
+
+	std::size_t position = 8;
+	std::uint64_t microseconds = 0;
+
+	while (position < data.size()) {
+		std::uint64_t delta, length;
+		CaptureRecord record;
+
+		if (!readVarint(data, position, delta) || position >= data.size()) {
+			break;
+		}
+
+		unsigned char flags = static_cast<unsigned char>(data[position++]);
+
+		if (!readVarint(data, position, length) || length > data.size() - position) {
+			break;
+		}
+
+		microseconds += delta;
+
+		record.time = microseconds * 1e-6;
+		record.channel = static_cast<CaptureChannel>(flags >> 1);
+		record.direction = static_cast<CaptureDirection>(flags & 1);
+		record.data.assign(data.data() + position, static_cast<std::size_t>(length));
+		position += static_cast<std::size_t>(length);
+
+		records.push_back(std::move(record));
+	}
+
+	if (position != data.size()) {
+		std::cerr << "The capture file " << path << " is truncated, " << records.size() << " records could be read" << std::endl;
+	}
+
+	return true;
+}
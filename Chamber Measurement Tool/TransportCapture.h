@@ -0,0 +1,74 @@
+#pragma once
+#include "BufferedFileWriter.h"
+#include <boost/chrono.hpp>
+#include <boost/thread/mutex.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+	Capture files hold every byte exchanged with the instruments during a session, with the time at which it was sent or received, so that the
+	session can later be replayed without the instruments.
+	The file starts with the magic "CMTC" and a 32 bit version number, followed by one record per read or write:
+	- the time since the previous record in microseconds, as a variable length integer
+	- a byte holding the channel in the upper bits and the direction in the lowest bit
+	- the number of data bytes, as a variable length integer
+	- the data bytes
+	Variable length integers are stored 7 bits at a time, least significant first, with the top bit set on every byte except the last.
+*/
+const char CAPTUREFILE_MAGIC[4] = { 'C', 'M', 'T', 'C' };
+const std::uint32_t CAPTUREFILE_VERSION = 1;
+
+/*
+	The instrument a record belongs to
+*/
+enum CaptureChannel {
+	ANALYSER_CHANNEL = 0,
+	ROTATOR_CHANNEL = 1
+};
+
+/*
+	Whether the bytes were sent to the instrument or received from it
+*/
+enum CaptureDirection {
+	TO_DEVICE = 0,
+	FROM_DEVICE = 1
+};
+
+/*
+	A single read or write of a capture file
+*/
+struct CaptureRecord {
+	double time; // Time since the start of the capture in seconds
+	CaptureChannel channel;
+	CaptureDirection direction;
+	std::string data; // The bytes which were exchanged
+};
+
+/*
+	Writes a capture file. The instrument objects call record() for every block of bytes they send or receive, from any thread.
+*/
+class TransportRecorder {
+private:
+	BufferedFileWriter m_writer;
+	boost::mutex m_mutex;
+
+	boost::chrono::steady_clock::time_point m_start; // Time at which the capture was opened
+	std::uint64_t m_lastMicroseconds; // Time of the previous record
+	std::uint64_t m_recordCount;
+
+public:
+	TransportRecorder();
+
+	bool open(const std::string &path);
+	bool close();
+	bool isOpen();
+
+	void record(CaptureChannel channel, CaptureDirection direction, const void *data, std::size_t length);
+
+	std::uint64_t getRecordCount();
+
+	~TransportRecorder();
+};
+
+bool readCapture(const std::string &path, std::vector<CaptureRecord> &records);
@@ -1,12 +1,102 @@
 #include "AnalyserObj.h"
 #include "SerialRotatorObj.h"
 #include "SerialRotatorException.h"
+#include "CampaignSimulator.h"
+#include "MeasurementSystem.h"
+#include "TransportCapture.h"
+#include <cstring>
+
+/*
+	Predicts the duration of a full azimuth cut with the settings used below, and of a few variations of it, without touching the instruments.
+	The latency profile is read from profileFile if one is given, otherwise the default profile is used.
+*/
+static int dryRun(const char *profileFile) {
+	LatencyProfile profile;
+
+	if (profileFile && !profile.load(profileFile)) {
+		return 1;
+	}
+
+	CampaignPlan plan;
+	plan.name = "baseline";
+	plan.stepAngle = 3;
+	plan.samplePoints = 1601;
+	plan.IFBW = 5e3;
+
+	std::vector<CampaignPlan> plans(5, plan);
+	plans[1].name = "pipelined";
+	plans[1].pipelined = true;
+	plans[2].name = "step 6";
+	plans[2].stepAngle = 6;
+	plans[3].name = "IFBW 20k";
+	plans[3].IFBW = 20e3;
+	plans[4].name = "801 points";
+	plans[4].samplePoints = 801;
+
+	CampaignSimulator simulator(profile);
+	simulator.simulate(plan).printSummary(std::cout);
+	std::cout << std::endl;
+	simulator.compare(plans, std::cout);
+
+	return 0;
+}
+
+/*
+	Records every byte exchanged with the instruments during two azimuth cuts from 0 to 90 degrees in a capture file. The settings are the same as
+	those of the replay benchmark, so that the capture can be replayed with Benchmarks --capture. Two cuts are recorded so that the capture
+	includes the move back to the start of the cut.
+*/
+static int recordSession(const char *captureFile) {
+	// Declared first so that it outlives the instruments
+	TransportRecorder recorder;
+
+	if (!recorder.open(captureFile)) {
+		return 1;
+	}
+
+	try {
+		MeasurementSystem system(new AnalyserObj<double>(400e6, 3e9, 0, 5e3, 1601, SMIT, S21, REAL32, "192.168.20.200", 23, &recorder),
+			new SerialRotatorObj(1, 255, 5, 4, 9600, &recorder));
+
+		for (int cut = 0; cut < 2; cut++) {
+			if (!system.measureCut(0, 90)) {
+				return 1;
+			}
+		}
+	}
+	catch (boost::system::system_error &e) {
+		std::cerr << "Unable to connect to the instruments" << std::endl;
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	catch (SerialRotatorException &e) {
+		std::cerr << "Something went wrong with the rotator" << std::endl;
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc > 1 && std::strcmp(argv[1], "--dry-run") == 0) {
+		return dryRun(argc > 2 ? argv[2] : nullptr);
+	}
+
+	if (argc > 2 && std::strcmp(argv[1], "--record-session") == 0) {
+		return recordSession(argv[2]);
+	}
 
-int main() {
 	try {
 		AnalyserObj<double> analyser(400e6, 3e9, 10, 5e3, 1601, MLOG, S21, REAL32, "192.168.20.200", 23);
 		
 		SerialRotatorObj serRot(1, 255, 3, 4, 9600);
+
+		// Record the timing of the instruments for use with --dry-run
+		if (argc > 2 && std::strcmp(argv[1], "--record-profile") == 0) {
+			return LatencyProfile::measure(analyser, serRot).save(argv[2]) ? 0 : 1;
+		}
+
 		serRot.rotateTo(90);
 	}
 	catch (boost::system::system_error &e) {